@@ -5,8 +5,6 @@
 
 #include "character_stream_buffer.hpp"
 
-#include <functional>
-
 
 /*******************************************************************************
  * CONSTRUCTORS & DESTRUCTOR
@@ -40,10 +38,11 @@ void hal::component::CharacterStreamBuffer<T>::bufferWrittenCallback(
      * any. There is not much we can do if write fails. */
     pending_out.pop_front();
     if (!pending_out.empty()) {
-        driver.asyncWrite(pending_out.front()->data(),
-                          pending_out.front()->size(),
-                          bind(&CharacterStreamBuffer::bufferWrittenCallback,
-                               this, placeholders::_1, placeholders::_2));
+        driver.asyncWrite(
+            pending_out.front()->data(), pending_out.front()->size(),
+            [this](size_t nb_written, device::ErrorStatus& status) {
+                bufferWrittenCallback(nb_written, status);
+            });
     }
 }
 
@@ -89,10 +88,11 @@ int hal::component::CharacterStreamBuffer<T>::sync()
     if (pending_out.size() == 1) {
         /* There are no other pending write requests, send this one now to the
          * driver */
-        driver.asyncWrite(pending_out.back()->data(),
-                          pending_out.back()->size(),
-                          bind(&CharacterStreamBuffer::bufferWrittenCallback,
-                               this, placeholders::_1, placeholders::_2));
+        driver.asyncWrite(
+            pending_out.back()->data(), pending_out.back()->size(),
+            [this](size_t nb_written, device::ErrorStatus& status) {
+                bufferWrittenCallback(nb_written, status);
+            });
     }
 
     /* Assumption: The size of all writes on this stream will be roughly the
@@ -39,7 +39,8 @@ using namespace device;
 
 Logger::Logger()
 : driver{System::getInstance().getEventLoop(),
-         System::getInstance().getUartWithDma(logging_uart_id)},
+         System::getInstance().getUartWithDma(logging_uart_id),
+         EventLoop::lowest_priority},
   buffer{driver}, os{&buffer}
 {
 }
@@ -0,0 +1,76 @@
+
+/*******************************************************************************
+ * Implementation file of the coroutine frame pool
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "coroutine.hpp"
+
+#ifdef __cpp_impl_coroutine
+
+using namespace std;
+using namespace hal;
+
+
+/*******************************************************************************
+ * STATIC VARIABLE DEFINITIONS
+ ******************************************************************************/
+
+CoroutineFramePool::Frame CoroutineFramePool::frames[nb_frames];
+atomic<uint32_t> CoroutineFramePool::used_frames{0};
+
+
+/*******************************************************************************
+ * PUBLIC METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+void* CoroutineFramePool::allocate(size_t size)
+{
+    if (size > frame_size) {
+        throw CoroutineFrameAllocFailure{};
+    }
+
+    uint32_t used = used_frames.load(memory_order_relaxed);
+
+    /* Claim the first free frame, retry if an interrupt claimed or released
+     * one in between */
+    while (true) {
+        size_t i = 0;
+        while (i < nb_frames && (used & (1UL << i))) { ++i; }
+        if (i == nb_frames) {
+            throw CoroutineFrameAllocFailure{};
+        }
+
+        if (used_frames.compare_exchange_weak(used, used | (1UL << i),
+                                              memory_order_acquire,
+                                              memory_order_relaxed)) {
+            return frames[i].bytes;
+        }
+    }
+}
+
+void CoroutineFramePool::deallocate(void* frame) noexcept
+{
+    size_t i = static_cast<Frame*>(frame) - frames;
+
+    used_frames.fetch_and(~(1UL << i), memory_order_release);
+}
+
+size_t CoroutineFramePool::getNbFreeFrames()
+{
+    uint32_t used = used_frames.load(memory_order_relaxed);
+    size_t nb_free = 0;
+
+    for (size_t i = 0; i < nb_frames; ++i) {
+        if (!(used & (1UL << i))) {
+            ++nb_free;
+        }
+    }
+
+    return nb_free;
+}
+
+#endif
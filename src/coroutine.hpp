@@ -0,0 +1,129 @@
+
+/*******************************************************************************
+ * Support for C++20 coroutines. A Task is a coroutine that starts running as
+ * soon as it is called and that may co_await the awaitables provided by the
+ * drivers. It is then resumed by the executor of the awaited driver, the same
+ * way a callback would have been called.
+ * Coroutine frames are never allocated on the heap but taken from a fixed pool.
+ ******************************************************************************/
+
+#ifndef _HAL_COROUTINE_HPP
+#define _HAL_COROUTINE_HPP
+
+#ifdef __cpp_impl_coroutine
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+    #include <atomic>
+    #include <coroutine>
+    #include <cstddef>
+    #include <cstdint>
+    #include <exception>
+
+
+/*******************************************************************************
+ * MACRO DEFINITION
+ ******************************************************************************/
+
+    /* Maximum number of coroutines alive at the same time, at most 32 */
+    #ifndef COROUTINE_POOL_NB_FRAMES
+        #define COROUTINE_POOL_NB_FRAMES 8
+    #endif
+
+    /* Size in bytes of each coroutine frame of the pool */
+    #ifndef COROUTINE_FRAME_SIZE
+        #define COROUTINE_FRAME_SIZE 256
+    #endif
+
+namespace hal
+{
+/*******************************************************************************
+ * CLASS DEFINITIONS
+ ******************************************************************************/
+
+class CoroutineFramePool
+{
+  public:
+    static constexpr std::size_t nb_frames  = COROUTINE_POOL_NB_FRAMES;
+    static constexpr std::size_t frame_size = COROUTINE_FRAME_SIZE;
+
+    static_assert(nb_frames > 0 && nb_frames <= 32,
+                  "Coroutine frame pool holds between 1 and 32 frames");
+
+    /** Take a frame from the pool. This is safe to call from any interrupt
+     * context.
+     * @throw CoroutineFrameAllocFailure if the pool is exhausted or the frame
+     * is larger than @ref frame_size */
+    static void* allocate(std::size_t size);
+    static void deallocate(void* frame) noexcept;
+
+    static std::size_t getNbFreeFrames();
+
+  private:
+    struct alignas(std::max_align_t) Frame {
+        unsigned char bytes[frame_size];
+    };
+
+    static Frame frames[nb_frames];
+    /* Bit i is set when frames[i] is in use */
+    static std::atomic<uint32_t> used_frames;
+};
+
+/** A detached coroutine: it runs until its first suspension point when called
+ * and its frame is released once it returns. Nothing owns the frame so it
+ * could not be released if an exception escaped the coroutine,
+ * std::terminate is called instead. */
+class Task
+{
+  public:
+    struct promise_type {
+        Task get_return_object() noexcept
+        {
+            return Task{};
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() noexcept
+        {
+        }
+
+        [[noreturn]] void unhandled_exception() noexcept
+        {
+            std::terminate();
+        }
+
+        static void* operator new(std::size_t size)
+        {
+            return CoroutineFramePool::allocate(size);
+        }
+
+        static void operator delete(void* frame) noexcept
+        {
+            CoroutineFramePool::deallocate(frame);
+        }
+    };
+};
+
+struct CoroutineFrameAllocFailure : std::exception {
+    const char* what() const noexcept override
+    {
+        return "Coroutine frame pool exhausted or frame too large";
+    }
+};
+
+}  // namespace hal
+
+#endif
+
+#endif
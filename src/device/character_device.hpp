@@ -13,7 +13,7 @@
 #include "error_status.hpp"
 
 #include <cstddef>
-#include <functional>
+#include <inplace_function.hpp>
 #include <optional>
 
 namespace hal
@@ -28,6 +28,8 @@ template<typename T>
 class CharacterDevice
 {
   public:
+    typedef InplaceFunction<void(size_t, ErrorStatus&&)> CompleteCallback;
+
     /** Set the callback function that will be called once the write operation
      * is complete (i.e. the specified number of bytes was written or the
      * operation failed). This will be called from an interrupt context.
@@ -35,10 +37,9 @@ class CharacterDevice
      *  The new callback function. It will receive as paramater the number of
      * bytes written and an error status indicating if the write operation was
      * succesfully executed or not. */
-    void setWriteCompleteCallback(
-        std::function<void(size_t, ErrorStatus&&)>&& callback)
+    void setWriteCompleteCallback(CompleteCallback&& callback)
     {
-        write_complete_callback = callback;
+        write_complete_callback = std::move(callback);
     }
     /** Set the callback function that will be called once the read operation
      * is complete (i.e. the specified number of bytes was read, the stop char
@@ -48,10 +49,9 @@ class CharacterDevice
      *  The new callback function. It will receive as paramater the number of
      * bytes read and an error status indicating if the read operation was
      * succesfully executed or not. */
-    void setReadCompleteCallback(
-        std::function<void(size_t, ErrorStatus&&)>&& callback)
+    void setReadCompleteCallback(CompleteCallback&& callback)
     {
-        read_complete_callback = callback;
+        read_complete_callback = std::move(callback);
     }
 
     /** Begin a write operation
@@ -84,8 +84,8 @@ class CharacterDevice
     virtual bool cancelRead(size_t& nb_read) = 0;
 
   protected:
-    std::function<void(size_t, ErrorStatus&&)> write_complete_callback;
-    std::function<void(size_t, ErrorStatus&&)> read_complete_callback;
+    CompleteCallback write_complete_callback;
+    CompleteCallback read_complete_callback;
 };
 
 }  // namespace device
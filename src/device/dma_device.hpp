@@ -11,9 +11,10 @@
  ******************************************************************************/
 
 #include "error_status.hpp"
+#include "exceptions/device_exceptions.hpp"
 
 #include <cstdint>
-#include <functional>
+#include <inplace_function.hpp>
 
 namespace hal
 {
@@ -29,6 +30,8 @@ class DmaDevice
     enum class TransferDirection { PeriphToMem, MemToPeriph, MemToMem };
     enum class DataWidth { Byte = 1, HalfWord = 2, Word = 4 };
     enum class TransferPriority { Low, Medium, High, VeryHigh };
+    typedef InplaceFunction<void(unsigned, size_t, ErrorStatus&&)>
+        TransferCompleteCallback;
     /** A data structure to represent either the source or the destination of a
      * DMA transfer. */
     struct Location {
@@ -61,25 +64,75 @@ class DmaDevice
                                size_t count,
                                TransferDirection dir,
                                TransferPriority prio) = 0;
+    /** Same as @ref startTransfer but the transfer restarts from the
+     * beginning of the buffers each time it completes, until it is cancelled.
+     * The transfer complete callback is called each time half of the transfer
+     * and the whole transfer are done, with the number of bytes transferred
+     * since the beginning of the buffers: count / 2 or count. It is called a
+     * last time with the Aborted status once the transfer is cancelled.
+     * Devices that do not support this mode raise
+     * @ref UnsupportedDeviceOperation. */
+    virtual void startCircularTransfer(unsigned stream_id,
+                                       const Location& src,
+                                       const Location& dst,
+                                       size_t count,
+                                       TransferDirection dir,
+                                       TransferPriority prio)
+    {
+        throw UnsupportedDeviceOperation{"startCircularTransfer"};
+    }
+    /** Same as @ref startCircularTransfer but the memory side alternates
+     * between two buffers of count bytes each. The memory location, src or
+     * dst depending on the direction, is the first buffer. While the device
+     * transfers one buffer, the other one may be refilled or replaced with
+     * @ref setDoubleBufferAddress.
+     * The transfer complete callback is called each time a buffer is released
+     * with the number of bytes transferred since the beginning of the first
+     * buffer, as if both made up one circular buffer: count for the first
+     * buffer and 2 * count for the second one.
+     * Devices that do not support this mode raise
+     * @ref UnsupportedDeviceOperation. */
+    virtual void startDoubleBufferTransfer(unsigned stream_id,
+                                           const Location& src,
+                                           const Location& dst,
+                                           std::uintptr_t second_buffer,
+                                           size_t count,
+                                           TransferDirection dir,
+                                           TransferPriority prio)
+    {
+        throw UnsupportedDeviceOperation{"startDoubleBufferTransfer"};
+    }
+    /** Replace buffer 0 or 1 of a double buffer transfer, it is used from the
+     * next time the device switches to it. Returns false if the device is
+     * transferring it, or switched to it while it was being replaced. The
+     * new address may then be in use already, or the transfer failed and the
+     * callback reports it. */
+    virtual bool setDoubleBufferAddress(unsigned stream_id,
+                                        unsigned buffer_idx,
+                                        std::uintptr_t addr)
+    {
+        throw UnsupportedDeviceOperation{"setDoubleBufferAddress"};
+    }
     virtual bool suspendTransfer(unsigned stream_id)  = 0;
     virtual bool cancelTransfer(unsigned stream_id)   = 0;
     virtual bool resumeTransfer(unsigned stream_id)   = 0;
+    /** Number of bytes the running transfer of the stream has yet to move,
+     * for a circular transfer this is counted from its current round */
+    virtual size_t getRemainingCount(unsigned stream_id) = 0;
 
-    /** Set the callback function that will be called once the transfer
-     * operation is complete. This will be called from an interrupt context.
+    /** Set the callback function that will be called once a transfer of the
+     * given stream is complete. Each stream has its own callback so that
+     * streams may serve unrelated peripherals. This will be called from an
+     * interrupt context.
+     * @param stream_id
+     *  The stream whose transfers are reported to the callback
      * @param callback
      *  The new callback function. It will receive as paramater the stream ID,
      * the number of bytes transfered and an error status indicating if the
      * transfer operation was succesfully executed or not. */
-    void setTransferCompleteCallback(
-        std::function<void(unsigned, size_t, ErrorStatus&&)>&& callback)
-    {
-        transfer_complete_callback = callback;
-    }
-
-  protected:
-    std::function<void(unsigned, size_t, ErrorStatus&&)>
-        transfer_complete_callback;
+    virtual void setTransferCompleteCallback(
+        unsigned stream_id,
+        TransferCompleteCallback&& callback) = 0;
 };
 
 }  // namespace device
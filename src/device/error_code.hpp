@@ -23,6 +23,7 @@ enum class ErrorCode {
     Success,  // Successful completion of operation
     Aborted,  // The operation was cancelled/aborted
     Failure,  // Failure of operation (unspecified cause)
+    Overrun,  // Data was lost because it was not consumed in time
     NbCodes
 };
 
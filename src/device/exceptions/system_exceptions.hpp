@@ -10,6 +10,7 @@
  * INCLUDE DIRECTIVES
  ******************************************************************************/
 
+#include <cstdint>
 #include <exception>
 #include <hardware/mcu.hpp>
 #include <string>
@@ -46,6 +47,26 @@ struct InvalidTimerIdException : SystemException {
     }
 };
 
+struct InvalidTimerTickRateException : SystemException {
+    unsigned id;
+    uint32_t tick_hz;
+
+    InvalidTimerTickRateException(unsigned id, uint32_t tick_hz)
+    : id{id}, tick_hz{tick_hz},
+      message{"Invalid tick rate for timer " + std::to_string(id) + ": "
+              + std::to_string(tick_hz) + " Hz"}
+    {
+    }
+
+    const char* what() const noexcept override
+    {
+        return message.c_str();
+    }
+
+  private:
+    std::string message;
+};
+
 struct InvalidUartIdException : SystemException {
     unsigned id;
 
@@ -72,6 +93,23 @@ struct InvalidDmaIdException : SystemException {
     }
 };
 
+struct InvalidInterruptExecutorIdException : SystemException {
+    unsigned id;
+
+    InvalidInterruptExecutorIdException(unsigned id)
+    : id{id}, message{"Invalid interrupt executor ID: " + std::to_string(id)}
+    {
+    }
+
+    const char* what() const noexcept override
+    {
+        return message.c_str();
+    }
+
+  private:
+    std::string message;
+};
+
 struct UnimplementedDeviceException : SystemException {
     std::string device_name;
 
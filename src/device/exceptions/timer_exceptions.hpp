@@ -37,11 +37,10 @@ struct TimerException : DeviceException {
 };
 
 struct InvalidTimerCountException : TimerException {
-    TimerDevice::WaitTimeUnitDuration::rep count;
-    TimerDevice::WaitTimeUnitDuration::rep max_count;
+    uint64_t count;
+    TimerDevice::TickCount max_count;
 
-    InvalidTimerCountException(TimerDevice::WaitTimeUnitDuration::rep count,
-                               TimerDevice::WaitTimeUnitDuration::rep max_count)
+    InvalidTimerCountException(uint64_t count, TimerDevice::TickCount max_count)
     : count{count}, max_count{max_count}
     {
     }
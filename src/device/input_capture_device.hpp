@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * Interface file for input capture devices: a counter whose value is latched
+ * on each edge of an input signal.
+ ******************************************************************************/
+
+#ifndef _HAL_DEVICE_INPUT_CAPTURE_DEVICE_HPP
+#define _HAL_DEVICE_INPUT_CAPTURE_DEVICE_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "error_status.hpp"
+#include "timer_device.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <inplace_function.hpp>
+
+namespace hal
+{
+namespace device
+{
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+class InputCaptureDevice
+{
+  public:
+    enum class Edge { Rising, Falling, Both };
+    typedef InplaceFunction<void(size_t, ErrorStatus&&)> CaptureCallback;
+
+    /** Set the callback function that will be called each time half of the
+     * ring buffer has been filled. This will be called from an interrupt
+     * context.
+     * @param callback
+     *  The new callback function. It will receive as parameter the number of
+     * captures written since the start of the ring buffer, i.e. half or all of
+     * its size, and an error status. Any status but Success means that
+     * capturing stopped. */
+    void setCaptureCallback(CaptureCallback&& callback)
+    {
+        capture_callback = std::move(callback);
+    }
+
+    /** Restart the counter from 0 and write its value to the ring buffer on
+     * each selected edge of the input. The buffer is filled from its start
+     * over and over until @ref stopCapture is called.
+     * @param ring
+     *  Must outlive the capture
+     * @param ring_size
+     *  The number of captures the ring buffer holds, it must be even */
+    virtual void startCapture(uint32_t* ring, size_t ring_size, Edge edge) = 0;
+    /** The capture callback is not called once this returns */
+    virtual void stopCapture() = 0;
+
+    /** Rate at which the captured counter ticks */
+    virtual TimerDevice::TickRate getTickRate() const = 0;
+    /** The counter wraps around to 0 after this value, it is one less than a
+     * power of 2 */
+    virtual uint32_t getMaxCount() const = 0;
+
+  protected:
+    CaptureCallback capture_callback;
+};
+
+}  // namespace device
+}  // namespace hal
+
+#endif
@@ -12,6 +12,8 @@
 
 #include "../hardware/mcu.hpp"
 
+#include <cstdint>
+
 
 /*******************************************************************************
  * DEFINE DIRECTIVES
@@ -44,14 +46,106 @@ __attribute__((aligned(0x200))) __attribute__((section(
 void handleError(void);
 }
 
+/*******************************************************************************
+ * IRQ LATENCY PROBE
+ * When built with IRQ_LATENCY_PROBE, every window during which interrupts are
+ * masked through disableInterrupts()/enableInterrupts() is timed using the DWT
+ * cycle counter and the longest one is kept.
+ ******************************************************************************/
+
+#ifdef IRQ_LATENCY_PROBE
+namespace irq_latency_probe
+{
+inline uint32_t masked_since      = 0;
+inline uint32_t max_masked_cycles = 0;
+
+inline void open()
+{
+    masked_since = DWT->CYCCNT;
+}
+
+inline void close()
+{
+    uint32_t masked_cycles = DWT->CYCCNT - masked_since;
+    if (masked_cycles > max_masked_cycles) {
+        max_masked_cycles = masked_cycles;
+    }
+}
+}  // namespace irq_latency_probe
+#endif
+
+/** Start the cycle counter used by the IRQ latency probe. This does nothing
+ * unless built with IRQ_LATENCY_PROBE. */
+inline void enableIrqLatencyProbe()
+{
+#ifdef IRQ_LATENCY_PROBE
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR    = 0xC5ACCE55; /* Unlock DWT registers */
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+/** Longest time interrupts were masked, in core clock cycles. Always 0 unless
+ * built with IRQ_LATENCY_PROBE. */
+inline uint32_t getMaxIrqMaskedCycles()
+{
+#ifdef IRQ_LATENCY_PROBE
+    return irq_latency_probe::max_masked_cycles;
+#else
+    return 0;
+#endif
+}
+
+inline void resetMaxIrqMaskedCycles()
+{
+#ifdef IRQ_LATENCY_PROBE
+    irq_latency_probe::max_masked_cycles = 0;
+#endif
+}
+
 inline void enableInterrupts()
 {
+#ifdef IRQ_LATENCY_PROBE
+    if (__get_PRIMASK()) {
+        irq_latency_probe::close();
+    }
+#endif
     __enable_irq();
 }
 
 inline void disableInterrupts()
 {
+#ifdef IRQ_LATENCY_PROBE
+    bool was_masked = __get_PRIMASK();
+#endif
     __disable_irq();
+#ifdef IRQ_LATENCY_PROBE
+    if (!was_masked) {
+        irq_latency_probe::open();
+    }
+#endif
+}
+
+/** Sleep until an interrupt is pending. This may be called with interrupts
+ * masked, in which case the core still wakes up as soon as an interrupt is
+ * pending but its handler will only run once interrupts are enabled again.
+ * Time spent asleep does not delay interrupt handling so it is not accounted
+ * for by the IRQ latency probe. */
+inline void waitForInterrupt()
+{
+#ifdef IRQ_LATENCY_PROBE
+    bool was_masked = __get_PRIMASK();
+    if (was_masked) {
+        irq_latency_probe::close();
+    }
+#endif
+    __WFI();
+#ifdef IRQ_LATENCY_PROBE
+    if (was_masked) {
+        irq_latency_probe::open();
+    }
+#endif
 }
 
 
@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Interface file for PWM devices: an output whose duty cycle may be changed at
+ * each period from a buffer of duty cycles.
+ ******************************************************************************/
+
+#ifndef _HAL_DEVICE_PWM_DEVICE_HPP
+#define _HAL_DEVICE_PWM_DEVICE_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "error_status.hpp"
+#include "timer_device.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <inplace_function.hpp>
+
+namespace hal
+{
+namespace device
+{
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+class PwmDevice
+{
+  public:
+    typedef InplaceFunction<void(size_t, ErrorStatus&&)> WaveformCallback;
+
+    /** Set the callback function that will be called once the duty cycles of
+     * a waveform have been consumed, or half of them for a circular one. This
+     * will be called from an interrupt context.
+     * @param callback
+     *  The new callback function. It will receive as parameter the number of
+     * duty cycles consumed since the start of the buffer and an error status.
+     * The buffer may be reused up to that point: its last duty cycle is still
+     * to be output during the next period. */
+    void setWaveformCallback(WaveformCallback&& callback)
+    {
+        waveform_callback = std::move(callback);
+    }
+
+    /** Duty cycles & periods are counted in ticks */
+    virtual TimerDevice::TickRate getTickRate() const = 0;
+    /** Largest period accepted by @ref setPeriod */
+    virtual uint32_t getMaxPeriod() const = 0;
+    /** The new period starts with the next one */
+    virtual void setPeriod(uint32_t period) = 0;
+    virtual uint32_t getPeriod() const      = 0;
+    /** The output is high during the first duty_cycle ticks of each period,
+     * a duty cycle of 0 keeps it low */
+    virtual void setDutyCycle(uint32_t duty_cycle) = 0;
+
+    /** Output one duty cycle of the buffer per period, starting with the next
+     * one. Once done, the output keeps the last duty cycle of the buffer.
+     * @param circular
+     *  If true, the buffer is output over and over until
+     * @ref stopWaveform is called, the callback is then called each time half
+     * of the buffer has been consumed. */
+    virtual void startWaveform(const uint32_t* duty_cycles,
+                               size_t nb_duty_cycles,
+                               bool circular) = 0;
+    /** The waveform callback is not called once this returns and the output
+     * is kept low */
+    virtual void stopWaveform() = 0;
+
+  protected:
+    WaveformCallback waveform_callback;
+};
+
+}  // namespace device
+}  // namespace hal
+
+#endif
@@ -9,7 +9,11 @@
 
 #include "stm32f750_dma.hpp"
 
+#include "stm32f750_dma_burst.hpp"
+
+#include <algorithm>
 #include <cstdint>
+#include <limits>
 #include <device/exceptions/dma_exceptions.hpp>
 
 using namespace std;
@@ -167,20 +171,31 @@ inline uint32_t Stm32f750Dma::transferDirectionToDIRBits(TransferDirection dir)
     }
 }
 
-/*******************************************************************************
- * PROTECTED METHOD IMPLEMENTATIONS
- ******************************************************************************/
-
-/*******************************************************************************
- * PUBLIC METHOD IMPLEMENTATIONS
- ******************************************************************************/
+inline uint32_t Stm32f750Dma::burstLengthToXBURSTBits(unsigned nb_beats)
+{
+    switch (nb_beats) {
+        case 1:
+            return 0b00;
+        case 4:
+            return 0b01;
+        case 8:
+            return 0b10;
+        case 16:
+            return 0b11;
+        default:
+            /* Unreachable */
+            throw DmaException{};
+    }
+}
 
-void Stm32f750Dma::startTransfer(unsigned stream_id,
-                                 const Location& src,
-                                 const Location& dst,
-                                 size_t count,
-                                 TransferDirection dir,
-                                 TransferPriority prio)
+void Stm32f750Dma::configureStream(unsigned stream_id,
+                                   const Location& src,
+                                   const Location& dst,
+                                   size_t count,
+                                   TransferDirection dir,
+                                   TransferPriority prio,
+                                   bool circular,
+                                   optional<uintptr_t> second_buffer)
 {
     if (stream_id >= nb_streams) {
         throw InvalidStreamIdException{stream_id};
@@ -190,8 +205,10 @@ void Stm32f750Dma::startTransfer(unsigned stream_id,
     volatile uint32_t* DMA_IFCR   = DMA_IFCR_ptr(stream_id);
     volatile uint32_t* DMA_SxPAR  = DMA_SxPAR_ptr(stream_id);
     volatile uint32_t* DMA_SxMA0R = DMA_SxM0AR_ptr(stream_id);
+    volatile uint32_t* DMA_SxMA1R = DMA_SxM1AR_ptr(stream_id);
     volatile uint32_t* DMA_SxNDTR = DMA_SxNDTR_ptr(stream_id);
     volatile uint32_t* DMA_SxFCR  = DMA_SxFCR_ptr(stream_id);
+    uintptr_t periph_addr, mem_addr;
     DataWidth periph_width, mem_width;
     bool periph_incr_addr, mem_incr_addr;
 
@@ -211,16 +228,16 @@ void Stm32f750Dma::startTransfer(unsigned stream_id,
         case TransferDirection::MemToMem:
             /* During a memory to memory transfer, the peripheral port is
              * repurposed as the source memory address. */
-            *DMA_SxPAR       = src.addr;
-            *DMA_SxMA0R      = dst.addr;
+            periph_addr      = src.addr;
+            mem_addr         = dst.addr;
             periph_width     = src.data_width;
             mem_width        = dst.data_width;
             periph_incr_addr = src.incr_addr;
             mem_incr_addr    = dst.incr_addr;
             break;
         case TransferDirection::MemToPeriph:
-            *DMA_SxPAR       = dst.addr;
-            *DMA_SxMA0R      = src.addr;
+            periph_addr      = dst.addr;
+            mem_addr         = src.addr;
             periph_width     = dst.data_width;
             mem_width        = src.data_width;
             periph_incr_addr = dst.incr_addr;
@@ -231,6 +248,16 @@ void Stm32f750Dma::startTransfer(unsigned stream_id,
             throw DmaException{};
             break;
     }
+    *DMA_SxPAR  = periph_addr;
+    *DMA_SxMA0R = mem_addr;
+
+    if (second_buffer) {
+        /* Double buffering only applies to the memory port */
+        if (dir == TransferDirection::MemToMem) {
+            throw UnsupportedDeviceOperation{"startDoubleBufferTransfer"};
+        }
+        *DMA_SxMA1R = *second_buffer;
+    }
 
     /* Step 4: Configure transfer size */
     if (count / static_cast<size_t>(periph_width)
@@ -240,14 +267,37 @@ void Stm32f750Dma::startTransfer(unsigned stream_id,
 
     *DMA_SxNDTR = count / static_cast<size_t>(periph_width);
 
-    /* Step 5: Configure FIFO usage */
-    /* TODO: direct mode selection, threshold selection */
-    *DMA_SxFCR |= DMA_SxFCR_FEIE;
+    /* Step 5: Configure FIFO usage. Direct mode moves each item to memory as
+     * soon as the peripheral requests it, it is kept for peripheral to
+     * memory transfers so that received data can be read right away.
+     * Otherwise the FIFO lets each port use its own data width and bursts,
+     * which the FIFO threshold must be a multiple of. */
+    unsigned mem_burst    = 1;
+    unsigned periph_burst = 1;
+    if (dir != TransferDirection::PeriphToMem || mem_width != periph_width) {
+        mem_burst = selectStm32f750DmaBurstLength(mem_addr, mem_width,
+                                                  mem_incr_addr, count);
+        if (second_buffer) {
+            mem_burst = min(mem_burst, selectStm32f750DmaBurstLength(
+                                           *second_buffer, mem_width,
+                                           mem_incr_addr, count));
+        }
+        /* The peripheral port may only burst when it accesses memory, a
+         * peripheral register expects one item per request */
+        if (dir == TransferDirection::MemToMem) {
+            periph_burst = selectStm32f750DmaBurstLength(
+                periph_addr, periph_width, periph_incr_addr, count);
+        }
+
+        *DMA_SxFCR = DMA_SxFCR_DMDIS | DMA_SxFCR_FTH | DMA_SxFCR_FEIE;
+    } else {
+        *DMA_SxFCR = DMA_SxFCR_FEIE;
+    }
 
     /* Step 6: Insert new transfer before enabling the hardware stream so that
      * if it fails the IRQ handler will release the memory immediately */
-    running_transfers[stream_id].reset(
-        new RunningTransfer{count, periph_width});
+    running_transfers[stream_id].reset(new RunningTransfer{
+        count, periph_width, circular, second_buffer.has_value(), 0});
 
     /* Step 7: Configure the channel, stream priority, data transfer
      * direction, peripheral and memory incremented/fixed mode, single
@@ -255,21 +305,102 @@ void Stm32f750Dma::startTransfer(unsigned stream_id,
      * Then enable the stream */
     *DMA_SxCR &= ~DMA_SxCR_CHSEL & ~DMA_SxCR_PL & ~DMA_SxCR_MSIZE
                  & ~DMA_SxCR_PSIZE & ~DMA_SxCR_MINC & ~DMA_SxCR_PINC
-                 & ~DMA_SxCR_DIR;
+                 & ~DMA_SxCR_DIR & ~DMA_SxCR_CIRC & ~DMA_SxCR_HTIE
+                 & ~DMA_SxCR_DBM & ~DMA_SxCR_CT & ~DMA_SxCR_MBURST
+                 & ~DMA_SxCR_PBURST;
+    if (second_buffer) {
+        /* The memory address switches between M0AR & M1AR, starting with
+         * M0AR, each time NDTR is reloaded. The transfer complete interrupt
+         * tells which buffer was released. */
+        *DMA_SxCR |= DMA_SxCR_DBM | DMA_SxCR_CIRC;
+    } else if (circular) {
+        /* NDTR is reloaded at the end of each round and the half transfer
+         * interrupt tells when the first half of the buffers may be used */
+        *DMA_SxCR |= DMA_SxCR_CIRC | DMA_SxCR_HTIE;
+    }
     NVIC_EnableIRQ(irq_nbs[stream_id]);
     *DMA_SxCR |= (selected_channels[stream_id] << DMA_SxCR_CHSEL_Pos)
                  | (priorityToPLBits(prio) << DMA_SxCR_PL_Pos)
                  | (dataWidthToXSIZEBits(mem_width) << DMA_SxCR_MSIZE_Pos)
                  | (dataWidthToXSIZEBits(periph_width) << DMA_SxCR_PSIZE_Pos)
+                 | (burstLengthToXBURSTBits(mem_burst) << DMA_SxCR_MBURST_Pos)
+                 | (burstLengthToXBURSTBits(periph_burst)
+                    << DMA_SxCR_PBURST_Pos)
                  | (mem_incr_addr << DMA_SxCR_MINC_Pos)
                  | (periph_incr_addr << DMA_SxCR_PINC_Pos)
                  | (transferDirectionToDIRBits(dir) << DMA_SxCR_DIR_Pos)
                  | DMA_SxCR_TCIE | DMA_SxCR_TEIE | DMA_SxCR_DMEIE | DMA_SxCR_EN;
+}
+
+/*******************************************************************************
+ * PROTECTED METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PUBLIC METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+void Stm32f750Dma::startTransfer(unsigned stream_id,
+                                 const Location& src,
+                                 const Location& dst,
+                                 size_t count,
+                                 TransferDirection dir,
+                                 TransferPriority prio)
+{
+    configureStream(stream_id, src, dst, count, dir, prio, false, nullopt);
+}
+
+void Stm32f750Dma::startCircularTransfer(unsigned stream_id,
+                                         const Location& src,
+                                         const Location& dst,
+                                         size_t count,
+                                         TransferDirection dir,
+                                         TransferPriority prio)
+{
+    configureStream(stream_id, src, dst, count, dir, prio, true, nullopt);
+}
 
-    /* TODO: Bust mode configuration
-     * it's a bit more complex than it seems because if we want to automatically
-     * deduce the burst & fifo configs then we must take care not to cross the
-     * 1KB address boundary or the AHB will raise an error. */
+void Stm32f750Dma::startDoubleBufferTransfer(unsigned stream_id,
+                                             const Location& src,
+                                             const Location& dst,
+                                             uintptr_t second_buffer,
+                                             size_t count,
+                                             TransferDirection dir,
+                                             TransferPriority prio)
+{
+    configureStream(stream_id, src, dst, count, dir, prio, true,
+                    second_buffer);
+}
+
+bool Stm32f750Dma::setDoubleBufferAddress(unsigned stream_id,
+                                          unsigned buffer_idx,
+                                          uintptr_t addr)
+{
+    if (stream_id >= nb_streams) {
+        throw InvalidStreamIdException{stream_id};
+    }
+    if (running_transfers[stream_id] == nullptr
+        || !running_transfers[stream_id]->double_buffer || buffer_idx > 1) {
+        throw UnsupportedDeviceOperation{"setDoubleBufferAddress"};
+    }
+
+    /* Writing the address of the buffer being transferred would raise a
+     * transfer error and disable the stream. CT tells which one it is. */
+    unsigned current_idx = (*DMA_SxCR_ptr(stream_id) & DMA_SxCR_CT) ? 1 : 0;
+    if (buffer_idx == current_idx) {
+        return false;
+    }
+
+    if (buffer_idx == 0) {
+        *DMA_SxM0AR_ptr(stream_id) = addr;
+    } else {
+        *DMA_SxM1AR_ptr(stream_id) = addr;
+    }
+
+    /* The device may have switched buffers in between, the write then either
+     * came in time or raised the transfer error */
+    current_idx = (*DMA_SxCR_ptr(stream_id) & DMA_SxCR_CT) ? 1 : 0;
+    return buffer_idx != current_idx;
 }
 
 bool Stm32f750Dma::suspendTransfer(unsigned stream_id)
@@ -296,6 +427,27 @@ bool Stm32f750Dma::cancelTransfer(unsigned stream_id)
     return true;
 }
 
+size_t Stm32f750Dma::getRemainingCount(unsigned stream_id)
+{
+    if (running_transfers[stream_id] == nullptr) {
+        return 0;
+    }
+
+    return *DMA_SxNDTR_ptr(stream_id)
+           * static_cast<size_t>(running_transfers[stream_id]->width);
+}
+
+void Stm32f750Dma::setTransferCompleteCallback(
+    unsigned stream_id,
+    TransferCompleteCallback&& callback)
+{
+    if (stream_id >= nb_streams) {
+        throw InvalidStreamIdException{stream_id};
+    }
+
+    transfer_complete_callbacks[stream_id] = move(callback);
+}
+
 void Stm32f750Dma::setChannel(unsigned stream_id, unsigned channel_id)
 {
     if (stream_id >= nb_streams) {
@@ -311,36 +463,82 @@ void Stm32f750Dma::setChannel(unsigned stream_id, unsigned channel_id)
 
 void Stm32f750Dma::onTransferComplete(unsigned stream_id)
 {
-    if (transfer_complete_callback) {
+    if (running_transfers[stream_id] == nullptr) {
+        return;
+    }
+
+    /* A circular transfer goes on unless the stream was disabled to cancel
+     * it, which also raises the transfer complete flag */
+    TransferCompleteCallback& callback = transfer_complete_callbacks[stream_id];
+    RunningTransfer& transfer          = *running_transfers[stream_id];
+    if (transfer.circular && (*DMA_SxCR_ptr(stream_id) & DMA_SxCR_EN)) {
+        size_t nb_transferred = transfer.count;
+        if (transfer.double_buffer) {
+            nb_transferred = (transfer.next_released + 1) * transfer.count;
+            transfer.next_released = 1 - transfer.next_released;
+        }
+
+        if (callback) {
+            callback(stream_id, nb_transferred, ErrorCode::Success);
+        }
+        return;
+    }
+
+    /* The callback may start the next transfer on this stream, which must
+     * not be mistaken for this one */
+    unique_ptr<RunningTransfer> done = move(running_transfers[stream_id]);
+    if (callback) {
         size_t nb_transferred =
-            running_transfers[stream_id]->count
-            - (*DMA_SxNDTR_ptr(stream_id)
-               * static_cast<uint32_t>(running_transfers[stream_id]->width));
-        transfer_complete_callback(
-            stream_id, nb_transferred,
-            nb_transferred == running_transfers[stream_id]->count ?
-                ErrorCode::Success :
-                ErrorCode::Aborted);
+            done->count
+            - (*DMA_SxNDTR_ptr(stream_id) * static_cast<uint32_t>(done->width));
+        callback(stream_id, nb_transferred,
+                 nb_transferred == done->count ? ErrorCode::Success :
+                                                 ErrorCode::Aborted);
+    }
+}
+
+void Stm32f750Dma::onHalfTransfer(unsigned stream_id)
+{
+    /* The flag is raised by every transfer but only circular ones enable its
+     * interrupt, double buffer ones report whole buffers only */
+    if (running_transfers[stream_id] == nullptr
+        || !running_transfers[stream_id]->circular
+        || running_transfers[stream_id]->double_buffer) {
+        return;
+    }
+
+    TransferCompleteCallback& callback = transfer_complete_callbacks[stream_id];
+    if (callback) {
+        callback(stream_id, running_transfers[stream_id]->count / 2,
+                 ErrorCode::Success);
     }
-    running_transfers[stream_id].release();
 }
 
 void Stm32f750Dma::onTransferError(unsigned stream_id)
 {
-    if (transfer_complete_callback) {
+    /* The transfer may have been reported complete by the same interrupt */
+    if (running_transfers[stream_id] == nullptr) {
+        return;
+    }
+
+    /* The callback may restart a transfer on this stream */
+    TransferCompleteCallback& callback = transfer_complete_callbacks[stream_id];
+    unique_ptr<RunningTransfer> failed = move(running_transfers[stream_id]);
+    if (callback) {
         size_t nb_transferred =
-            running_transfers[stream_id]->count
+            failed->count
             - (*DMA_SxNDTR_ptr(stream_id)
-               * static_cast<uint32_t>(running_transfers[stream_id]->width));
-        transfer_complete_callback(stream_id, nb_transferred,
-                                   ErrorCode::Failure);
+               * static_cast<uint32_t>(failed->width));
+        callback(stream_id, nb_transferred, ErrorCode::Failure);
     }
-    running_transfers[stream_id].release();
 }
 
 void Stm32f750Dma::onDirectModeError(unsigned stream_id)
 {
-    onDirectModeError(stream_id);
+    /* Only raised in direct mode when the memory address is not incremented
+     * and a request comes before the previous item was written. The stream
+     * goes on, there is nothing to recover. */
+    (void)stream_id;
 }
 
 void Stm32f750Dma::onFifoError(unsigned stream_id)
@@ -349,19 +547,26 @@ void Stm32f750Dma::onFifoError(unsigned stream_id)
      * check if this is an underrun or overrun issue, resolve the issue and go
      * on. */
 
+    /* The transfer may have been reported complete or failed by the same
+     * interrupt, the stream is then already disabled */
+    if (running_transfers[stream_id] == nullptr) {
+        return;
+    }
+
     volatile uint32_t* DMA_SxCR = DMA_SxCR_ptr(stream_id);
     *DMA_SxCR &= ~DMA_SxCR_EN;
     while (*DMA_SxCR & DMA_SxCR_EN) {}
 
-    if (transfer_complete_callback) {
+    /* The callback may restart a transfer on this stream */
+    TransferCompleteCallback& callback = transfer_complete_callbacks[stream_id];
+    unique_ptr<RunningTransfer> failed = move(running_transfers[stream_id]);
+    if (callback) {
         size_t nb_transferred =
-            running_transfers[stream_id]->count
+            failed->count
             - (*DMA_SxNDTR_ptr(stream_id)
-               * static_cast<uint32_t>(running_transfers[stream_id]->width));
-        transfer_complete_callback(stream_id, nb_transferred,
-                                   ErrorCode::Failure);
+               * static_cast<uint32_t>(failed->width));
+        callback(stream_id, nb_transferred, ErrorCode::Failure);
     }
-    running_transfers[stream_id].release();
 }
 
 
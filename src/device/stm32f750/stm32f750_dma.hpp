@@ -15,6 +15,7 @@
 #include <device/exceptions/dma_exceptions.hpp>
 #include <hardware/mcu.hpp>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -45,9 +46,29 @@ class Stm32f750Dma : public DmaDevice
                        size_t count,
                        TransferDirection dir,
                        TransferPriority prio) override;
+    void startCircularTransfer(unsigned stream_id,
+                               const Location& src,
+                               const Location& dst,
+                               size_t count,
+                               TransferDirection dir,
+                               TransferPriority prio) override;
+    void startDoubleBufferTransfer(unsigned stream_id,
+                                   const Location& src,
+                                   const Location& dst,
+                                   std::uintptr_t second_buffer,
+                                   size_t count,
+                                   TransferDirection dir,
+                                   TransferPriority prio) override;
+    bool setDoubleBufferAddress(unsigned stream_id,
+                                unsigned buffer_idx,
+                                std::uintptr_t addr) override;
     bool suspendTransfer(unsigned stream_id) override;
     bool resumeTransfer(unsigned stream_id) override;
     bool cancelTransfer(unsigned stream_id) override;
+    size_t getRemainingCount(unsigned stream_id) override;
+    void setTransferCompleteCallback(
+        unsigned stream_id,
+        TransferCompleteCallback&& callback) override;
 
     /** When transferring to or from a peripheral, this function must be called
      * prior to starting the transfer in order to select which peripheral will
@@ -56,6 +77,7 @@ class Stm32f750Dma : public DmaDevice
     void setChannel(unsigned stream_id, unsigned channel_id);
 
     void onTransferComplete(unsigned stream_id);
+    void onHalfTransfer(unsigned stream_id);
     void onTransferError(unsigned stream_id);
     void onDirectModeError(unsigned stream_id);
     void onFifoError(unsigned stream_id);
@@ -125,8 +147,24 @@ class Stm32f750Dma : public DmaDevice
     struct RunningTransfer {
         size_t count;
         DataWidth width;
+        /* Circular transfers only end when cancelled */
+        bool circular;
+        /* Double buffer transfers are circular, their buffers are released
+         * alternately starting with buffer 0 */
+        bool double_buffer;
+        unsigned next_released;
     };
 
+    /** A second buffer makes it a double buffer transfer */
+    void configureStream(unsigned stream_id,
+                         const Location& src,
+                         const Location& dst,
+                         size_t count,
+                         TransferDirection dir,
+                         TransferPriority prio,
+                         bool circular,
+                         std::optional<std::uintptr_t> second_buffer);
+
     inline volatile uint32_t* DMA_ISR_ptr(unsigned stream_id);
     inline volatile uint32_t* DMA_IFCR_ptr(unsigned stream_id);
     inline volatile uint32_t* DMA_SxCR_ptr(unsigned stream_id);
@@ -139,6 +177,7 @@ class Stm32f750Dma : public DmaDevice
     static inline uint32_t priorityToPLBits(TransferPriority prio);
     static inline uint32_t dataWidthToXSIZEBits(DataWidth data_width);
     static inline uint32_t transferDirectionToDIRBits(TransferDirection dir);
+    static inline uint32_t burstLengthToXBURSTBits(unsigned nb_beats);
 
     static constexpr unsigned nb_channels_per_stream = 8;
 
@@ -147,6 +186,8 @@ class Stm32f750Dma : public DmaDevice
     const std::array<IRQn_Type, nb_streams> irq_nbs;
     std::array<unsigned, nb_streams> selected_channels;
     std::array<std::unique_ptr<RunningTransfer>, nb_streams> running_transfers;
+    std::array<TransferCompleteCallback, nb_streams>
+        transfer_complete_callbacks;
     volatile uint32_t* const clk_en_reg;
     const uint32_t clk_en_msk;
     volatile uint32_t* const rst_reg;
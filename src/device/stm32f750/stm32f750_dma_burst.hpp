@@ -0,0 +1,71 @@
+
+/*******************************************************************************
+ * Burst selection of the DMA streams of STM32F750. It only depends on the
+ * transfer layout, not on the hardware registers, so that it is shared with
+ * host tests.
+ ******************************************************************************/
+
+#ifndef _HAL_DEVICE_STM32F750_DMA_BURST_HPP
+#define _HAL_DEVICE_STM32F750_DMA_BURST_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+#include <device/dma_device.hpp>
+
+
+namespace hal
+{
+namespace device
+{
+/*******************************************************************************
+ * CONSTANT DEFINITIONS
+ ******************************************************************************/
+
+/* Size of the FIFO of each stream in bytes */
+constexpr size_t stm32f750_dma_fifo_size = 16;
+/* AHB bursts must not cross this boundary */
+constexpr size_t ahb_burst_boundary = 1024;
+
+
+/*******************************************************************************
+ * FUNCTION DEFINITIONS
+ ******************************************************************************/
+
+/** Longest burst, in beats, that a port may use to access a location when the
+ * FIFO is enabled. 1 means single transfers.
+ * @param count
+ *  Size of the transfer in bytes */
+constexpr unsigned
+    selectStm32f750DmaBurstLength(std::uintptr_t addr,
+                                  DmaDevice::DataWidth data_width,
+                                  bool incr_addr,
+                                  size_t count)
+{
+    if (!incr_addr) {
+        return 1;
+    }
+
+    for (unsigned nb_beats : {16U, 8U, 4U}) {
+        size_t burst_size = nb_beats * static_cast<size_t>(data_width);
+
+        /* A burst must fit in the FIFO, and be a divisor of the threshold
+         * which is always a full FIFO. A burst aligned on its own size never
+         * crosses a 1 KB boundary, which the AHB does not allow. The last
+         * burst must not overrun the transfer. */
+        if (burst_size <= stm32f750_dma_fifo_size && addr % burst_size == 0
+            && count % burst_size == 0) {
+            return nb_beats;
+        }
+    }
+
+    return 1;
+}
+
+}  // namespace device
+}  // namespace hal
+
+#endif
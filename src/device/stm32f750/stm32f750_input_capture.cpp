@@ -0,0 +1,189 @@
+/*******************************************************************************
+ * Implementation file for the input capture channels of STM32F750 timers
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "stm32f750_input_capture.hpp"
+
+#include "stm32f750_timer.hpp"
+
+#include <hardware/mcu.hpp>
+
+using namespace std;
+using namespace hal::device;
+
+
+/*******************************************************************************
+ * CONSTRUCTORS & DESTRUCTOR
+ ******************************************************************************/
+
+Stm32f750InputCapture::Stm32f750InputCapture(TIM_TypeDef* hw_timer,
+                                             volatile uint32_t* clk_en_reg,
+                                             uint32_t clk_en_msk,
+                                             volatile uint32_t* rst_reg,
+                                             uint32_t rst_msk,
+                                             size_t counter_sz,
+                                             size_t channel,
+                                             uint32_t timer_clk_hz,
+                                             uint32_t tick_hz,
+                                             Stm32f750Dma& dma,
+                                             unsigned dma_stream_id,
+                                             unsigned dma_chan_id)
+: hw_timer{hw_timer}, clk_en_reg{clk_en_reg}, clk_en_msk{clk_en_msk},
+  max_count{static_cast<uint32_t>((1ULL << counter_sz) - 1)},
+  channel{channel}, timer_clk_hz{timer_clk_hz},
+  prescaler_div{Stm32f750Timer::computePrescalerDiv(timer_clk_hz, tick_hz)},
+  dma{dma}, dma_stream_id{dma_stream_id}
+{
+    *clk_en_reg |= clk_en_msk;
+
+    /* Disable timer while we are configuring it */
+    hw_timer->CR1 &= ~TIM_CR1_CEN;
+    /* Reset timer */
+    *rst_reg |= rst_msk;
+    *rst_reg &= ~rst_msk;
+
+    /* Increment the time counter every PSC + 1 clock ticks, over the whole
+     * counter range */
+    hw_timer->PSC = (uint16_t)(prescaler_div - 1);
+    hw_timer->ARR = max_count;
+
+    /* Channels 1 & 2 are set in CCMR1, 3 & 4 in CCMR2, 8 bits each: map the
+     * channel to its own input, without filter nor prescaler */
+    volatile uint32_t* ccmr = (channel < 2) ? &hw_timer->CCMR1
+                                            : &hw_timer->CCMR2;
+    unsigned ccmr_shift     = 8 * (channel % 2);
+    *ccmr = (*ccmr & ~(0xFFUL << ccmr_shift))
+            | (TIM_CCMR1_CC1S_0 << ccmr_shift);
+
+    dma.setChannel(dma_stream_id, dma_chan_id);
+    dma.setTransferCompleteCallback(
+        dma_stream_id,
+        [this](unsigned, size_t count, ErrorStatus&& err) {
+            dmaTransferCompleted(count, move(err));
+        });
+}
+
+Stm32f750InputCapture::~Stm32f750InputCapture()
+{
+    if (capturing) {
+        stopCapture();
+    }
+    dma.setTransferCompleteCallback(dma_stream_id, nullptr);
+    hw_timer->CR1 &= ~TIM_CR1_CEN;
+    *clk_en_reg &= ~clk_en_msk;
+}
+
+
+/*******************************************************************************
+ * OPERATOR IMPLEMENTATIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PRIVATE METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+void Stm32f750InputCapture::dmaTransferCompleted(size_t count,
+                                                 ErrorStatus&& err)
+{
+    if (!capturing) {
+        return;
+    }
+
+    /* The DMA disables the stream on error */
+    if (err) {
+        capturing = false;
+        hw_timer->CR1 &= ~TIM_CR1_CEN;
+    }
+
+    if (capture_callback) {
+        capture_callback(count / sizeof(uint32_t), move(err));
+    }
+}
+
+/*******************************************************************************
+ * PROTECTED METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PUBLIC METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+void Stm32f750InputCapture::startCapture(uint32_t* ring,
+                                         size_t ring_size,
+                                         Edge edge)
+{
+    /* CCxE, CCxP & CCxNP of each channel are 4 bits apart */
+    unsigned ccer_shift = 4 * channel;
+    uint32_t polarity;
+
+    switch (edge) {
+        case Edge::Rising:
+            polarity = 0;
+            break;
+        case Edge::Falling:
+            polarity = TIM_CCER_CC1P;
+            break;
+        case Edge::Both:
+            polarity = TIM_CCER_CC1P | TIM_CCER_CC1NP;
+            break;
+        default:
+            /* Unreachable */
+            throw UnsupportedDeviceOperation{"startCapture"};
+    }
+
+    if (capturing) {
+        stopCapture();
+    }
+
+    hw_timer->CCER = (hw_timer->CCER
+                      & ~((TIM_CCER_CC1E | TIM_CCER_CC1P | TIM_CCER_CC1NP)
+                          << ccer_shift))
+                     | (polarity << ccer_shift);
+
+    /* Reading the capture register clears the capture flag so each edge
+     * yields one DMA request */
+    DmaDevice::Location src = {
+        reinterpret_cast<uintptr_t>(&(&hw_timer->CCR1)[channel]),
+        DmaDevice::DataWidth::Word, false};
+    DmaDevice::Location dst = {reinterpret_cast<uintptr_t>(ring),
+                               DmaDevice::DataWidth::Word, true};
+
+    dma.startCircularTransfer(dma_stream_id, src, dst,
+                              ring_size * sizeof(uint32_t),
+                              DmaDevice::TransferDirection::PeriphToMem,
+                              DmaDevice::TransferPriority::VeryHigh);
+    capturing = true;
+
+    /* Restart the counter from 0 and discard edges captured beforehand */
+    hw_timer->CR1 |= TIM_CR1_URS;
+    hw_timer->EGR = TIM_EGR_UG;
+    hw_timer->SR  = 0;
+    hw_timer->DIER |= TIM_DIER_CC1DE << channel;
+    hw_timer->CCER |= TIM_CCER_CC1E << ccer_shift;
+    hw_timer->CR1 |= TIM_CR1_CEN;
+}
+
+void Stm32f750InputCapture::stopCapture()
+{
+    /* The DMA reports the cancellation, it must be ignored */
+    capturing = false;
+
+    hw_timer->CCER &= ~(TIM_CCER_CC1E << (4 * channel));
+    hw_timer->DIER &= ~(TIM_DIER_CC1DE << channel);
+    hw_timer->CR1 &= ~TIM_CR1_CEN;
+    dma.cancelTransfer(dma_stream_id);
+}
+
+TimerDevice::TickRate Stm32f750InputCapture::getTickRate() const
+{
+    return TimerDevice::TickRate{timer_clk_hz, prescaler_div};
+}
+
+uint32_t Stm32f750InputCapture::getMaxCount() const
+{
+    return max_count;
+}
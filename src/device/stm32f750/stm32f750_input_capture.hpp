@@ -0,0 +1,83 @@
+/*******************************************************************************
+ * Interface file for the input capture channels of STM32F750 timers. Captured
+ * counter values are moved to memory by a DMA stream so that the CPU is only
+ * interrupted once per half ring buffer, whatever the edge rate.
+ ******************************************************************************/
+
+#ifndef _HAL_DEVICE_STM32F750_INPUT_CAPTURE_HPP
+#define _HAL_DEVICE_STM32F750_INPUT_CAPTURE_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "stm32f750_dma.hpp"
+
+#include <cstdint>
+#include <device/input_capture_device.hpp>
+#include <hardware/mcu.hpp>
+
+namespace hal
+{
+namespace device
+{
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+class Stm32f750InputCapture : public InputCaptureDevice
+{
+  public:
+    /** Construct an input capture object for the STM32F750 MCU. The timer
+     * will be reset and fully owned by this object.
+     * /!\ This call will not configure GPIOs.
+     * @param channel
+     *  The capture/compare channel of the timer, channel 0 is the hardware
+     * channel 1
+     * @param dma_stream_id
+     * @param dma_chan_id
+     *  The DMA stream & channel receiving the requests of the timer channel
+     * (cf reference manual) */
+    Stm32f750InputCapture(TIM_TypeDef* hw_timer,
+                          volatile uint32_t* clk_en_reg,
+                          uint32_t clk_en_msk,
+                          volatile uint32_t* rst_reg,
+                          uint32_t rst_msk,
+                          size_t counter_sz,
+                          size_t channel,
+                          uint32_t timer_clk_hz,
+                          uint32_t tick_hz,
+                          Stm32f750Dma& dma,
+                          unsigned dma_stream_id,
+                          unsigned dma_chan_id);
+    ~Stm32f750InputCapture();
+
+    void startCapture(uint32_t* ring, size_t ring_size, Edge edge) override;
+    void stopCapture() override;
+
+    TimerDevice::TickRate getTickRate() const override;
+    uint32_t getMaxCount() const override;
+
+  private:
+    TIM_TypeDef* const hw_timer;
+
+    volatile uint32_t* const clk_en_reg;
+    const uint32_t clk_en_msk;
+
+    const uint32_t max_count;
+    const size_t channel;
+    const uint32_t timer_clk_hz;
+    const uint32_t prescaler_div;
+
+    Stm32f750Dma& dma;
+    const unsigned dma_stream_id;
+
+    bool capturing = false;
+
+    void dmaTransferCompleted(size_t count, ErrorStatus&& err);
+};
+
+}  // namespace device
+}  // namespace hal
+
+#endif
@@ -12,6 +12,7 @@
 #include "stm32f750_dma.hpp"
 #include "stm32f750_timer.hpp"
 #include "stm32f750_uart.hpp"
+#include "stm32f750_uart_with_dma.hpp"
 
 #include <cstdio>
 #include <device/system.hpp>
@@ -43,13 +44,22 @@ static System& sys = System::getInstance();
 
 static inline void mHandleTimerEvent(TIM_TypeDef* timer, unsigned id)
 {
+    /* The line may be shared with a timer that was not built, or that is used
+     * for PWM or input capture: its clock is then disabled or it enables no
+     * interrupt. UIF & CCxIF are at the same position as UIE & CCxIE. */
+    constexpr uint32_t it_flags = TIM_SR_UIF | TIM_SR_CC1IF | TIM_SR_CC2IF
+                                  | TIM_SR_CC3IF | TIM_SR_CC4IF;
+    if ((timer->SR & timer->DIER & it_flags) == 0) {
+        return;
+    }
+
     try {
         Stm32f750Timer& timer_dev =
-            static_cast<Stm32f750Timer&>(sys.getTimer(id));
+            static_cast<Stm32f750Timer&>(sys.getTimerDevice(id));
 
         if ((timer->SR & TIM_SR_UIF) == TIM_SR_UIF) {
-            /* clear interrupt */
-            timer->SR &= ~TIM_SR_UIF;
+            /* The device clears the interrupt itself, along with the update
+             * of its overflow count */
             try {
                 timer_dev.onUpdateInterrupt();
             } catch (const std::exception& e) {
@@ -58,6 +68,23 @@ static inline void mHandleTimerEvent(TIM_TypeDef* timer, unsigned id)
                 handleError();
             }
         }
+
+        /* Handled after the update interrupt so that the free-running counter
+         * is up to date. Channels 1 to 4 have consecutive flags. */
+        for (size_t channel = 0; channel < 4; ++channel) {
+            if ((timer->DIER & (TIM_DIER_CC1IE << channel))
+                && (timer->SR & (TIM_SR_CC1IF << channel))) {
+                /* clear interrupt */
+                timer->SR = ~(TIM_SR_CC1IF << channel);
+                try {
+                    timer_dev.onCaptureCompareInterrupt(channel);
+                } catch (const std::exception& e) {
+                    // TODO: Is there anything better we can do here?
+                    printf("%s\r\n", e.what());
+                    handleError();
+                }
+            }
+        }
     } catch (const std::exception& e) {
         // TODO: Is there anything better we can do here?
         printf("%s\r\n", e.what());
@@ -68,9 +95,23 @@ static inline void mHandleTimerEvent(TIM_TypeDef* timer, unsigned id)
 static inline void mHandleUartEvent(USART_TypeDef* uart, unsigned id)
 {
     try {
+        uint32_t cr1 = uart->CR1;
+        uint32_t isr = uart->ISR;
+
+        /* Only the UART with DMA listens to the idle line */
+        if ((cr1 & USART_CR1_IDLEIE) && (isr & USART_ISR_IDLE)) {
+            /* clear interrupt */
+            uart->ICR = USART_ICR_IDLECF;
+            static_cast<Stm32f750UartWithDma&>(sys.getUartWithDma(id))
+                .onIdleLine();
+        }
+
+        /* Do not construct the regular UART on behalf of the UART with DMA */
+        if (!(cr1 & (USART_CR1_TXEIE | USART_CR1_RXNEIE))) {
+            return;
+        }
+
         Stm32f750Uart& uart_dev = static_cast<Stm32f750Uart&>(sys.getUart(id));
-        uint32_t cr1            = uart->CR1;
-        uint32_t isr            = uart->ISR;
         if ((cr1 & USART_CR1_TXEIE) && (isr & USART_ISR_TXE)) {
             /* Transmit data registry empty and we want to send data.
              * TXE bit will be cleared when writing the next char to the TDR
@@ -90,45 +131,72 @@ static inline void mHandleUartEvent(USART_TypeDef* uart, unsigned id)
     }
 }
 
-/* Here the various flag bitmasks are given as parameters because they are
- * calculated using constexpr and the stream_id is known at compile time. */
+static inline TIM_TypeDef* mGetTimerRegisters(unsigned id)
+{
+    switch (id) {
+        case 1: return TIM1;
+        case 2: return TIM2;
+        case 3: return TIM3;
+        case 4: return TIM4;
+        case 5: return TIM5;
+        case 6: return TIM6;
+        case 7: return TIM7;
+        case 8: return TIM8;
+        case 9: return TIM9;
+        case 10: return TIM10;
+        case 11: return TIM11;
+        case 12: return TIM12;
+        case 13: return TIM13;
+        default: return TIM14;
+    }
+}
+
+/* Templates cannot have C linkage */
+extern "C++" {
+/* The flag bitmasks are computed at compile time from the stream ID. All the
+ * flags of the stream are read and cleared at once. */
+template<unsigned stream_id>
 static inline void mHandleDmaEvent(volatile uint32_t* isr,
                                    volatile uint32_t* ifcr,
-                                   unsigned dma_id,
-                                   unsigned stream_id,
-                                   uint32_t TCIFx,
-                                   uint32_t CTCIFx,
-                                   uint32_t TEIFx,
-                                   uint32_t CTEIFx,
-                                   uint32_t DMEIFx,
-                                   uint32_t CDMEIFx,
-                                   uint32_t FEIFx,
-                                   uint32_t CFEIFx)
+                                   unsigned dma_id)
 {
+    constexpr uint32_t TCIFx  = Stm32f750Dma::TCIFx(stream_id);
+    constexpr uint32_t HTIFx  = Stm32f750Dma::HTIFx(stream_id);
+    constexpr uint32_t TEIFx  = Stm32f750Dma::TEIFx(stream_id);
+    constexpr uint32_t DMEIFx = Stm32f750Dma::DMEIFx(stream_id);
+    constexpr uint32_t FEIFx  = Stm32f750Dma::FEIFx(stream_id);
+
     try {
         Stm32f750Dma& dma_dev = static_cast<Stm32f750Dma&>(sys.getDma(dma_id));
 
-        if (*isr & TCIFx) {
+        /* Clear flags are at the same position as the status flags */
+        uint32_t flags = *isr & (TCIFx | HTIFx | TEIFx | DMEIFx | FEIFx);
+        *ifcr          = flags;
+
+        /* Handled first so that the callback of a circular transfer reports
+         * both halves in order */
+        if (flags & HTIFx) {
+            /* Half transfer interrupt */
+            dma_dev.onHalfTransfer(stream_id);
+        }
+
+        if (flags & TCIFx) {
             /* Transfer complete interrupt */
-            *ifcr |= CTCIFx;
             dma_dev.onTransferComplete(stream_id);
         }
 
-        if (*isr & TEIFx) {
+        if (flags & TEIFx) {
             /* Transfer error */
-            *ifcr |= CTEIFx;
             dma_dev.onTransferError(stream_id);
         }
 
-        if (*isr & DMEIFx) {
+        if (flags & DMEIFx) {
             /* Direct mode error */
-            *ifcr |= CDMEIFx;
             dma_dev.onDirectModeError(stream_id);
         }
 
-        if (*isr & FEIFx) {
+        if (flags & FEIFx) {
             /* FIFO error */
-            *ifcr |= CFEIFx;
             dma_dev.onFifoError(stream_id);
         }
     } catch (const std::exception& e) {
@@ -138,6 +206,82 @@ static inline void mHandleDmaEvent(volatile uint32_t* isr,
     }
 }
 
+/* Each timer of the line is handled in turn, timer IDs are mapped to their
+ * registers at compile time */
+template<unsigned... ids>
+static void mHandleTimerEvent(void)
+{
+    (mHandleTimerEvent(mGetTimerRegisters(ids), ids), ...);
+}
+
+/* Streams 0 to 3 use the low registers, 4 to 7 the high ones */
+template<unsigned dma_id, unsigned stream_id>
+static void mHandleDmaStreamEvent(void)
+{
+    DMA_TypeDef* dma = (dma_id == 1) ? DMA1 : DMA2;
+
+    if (stream_id > 3) {
+        mHandleDmaEvent<stream_id>(&dma->HISR, &dma->HIFCR, dma_id);
+    } else {
+        mHandleDmaEvent<stream_id>(&dma->LISR, &dma->LIFCR, dma_id);
+    }
+}
+}
+
+static inline void mHandleSoftwareInterrupt(unsigned id)
+{
+    try {
+        sys.getInterruptExecutor(id).onSoftwareInterrupt();
+    } catch (const std::exception& e) {
+        // TODO: Is there anything better we can do here?
+        printf("%s\r\n", e.what());
+        handleError();
+    }
+}
+
+
+/*******************************************************************************
+ * EXTERN CONSTANT DEFINITIONS
+ ******************************************************************************/
+
+extern "C++" constexpr std::array<DmaStreamIrq, nb_dma_stream_irqs>
+    hal::device::dma_stream_irqs = {{
+    {DMA1_Stream0_IRQn, mHandleDmaStreamEvent<1, 0>},
+    {DMA1_Stream1_IRQn, mHandleDmaStreamEvent<1, 1>},
+    {DMA1_Stream2_IRQn, mHandleDmaStreamEvent<1, 2>},
+    {DMA1_Stream3_IRQn, mHandleDmaStreamEvent<1, 3>},
+    {DMA1_Stream4_IRQn, mHandleDmaStreamEvent<1, 4>},
+    {DMA1_Stream5_IRQn, mHandleDmaStreamEvent<1, 5>},
+    {DMA1_Stream6_IRQn, mHandleDmaStreamEvent<1, 6>},
+    {DMA1_Stream7_IRQn, mHandleDmaStreamEvent<1, 7>},
+    {DMA2_Stream0_IRQn, mHandleDmaStreamEvent<2, 0>},
+    {DMA2_Stream1_IRQn, mHandleDmaStreamEvent<2, 1>},
+    {DMA2_Stream2_IRQn, mHandleDmaStreamEvent<2, 2>},
+    {DMA2_Stream3_IRQn, mHandleDmaStreamEvent<2, 3>},
+    {DMA2_Stream4_IRQn, mHandleDmaStreamEvent<2, 4>},
+    {DMA2_Stream5_IRQn, mHandleDmaStreamEvent<2, 5>},
+    {DMA2_Stream6_IRQn, mHandleDmaStreamEvent<2, 6>},
+    {DMA2_Stream7_IRQn, mHandleDmaStreamEvent<2, 7>},
+}};
+
+extern "C++" constexpr std::array<TimerIrq, nb_timer_irqs>
+    hal::device::timer_irqs = {{
+    {TIM1_UP_TIM10_IRQn, mHandleTimerEvent<1, 10>},
+    {TIM1_CC_IRQn, mHandleTimerEvent<1>},
+    {TIM1_BRK_TIM9_IRQn, mHandleTimerEvent<9>},
+    {TIM1_TRG_COM_TIM11_IRQn, mHandleTimerEvent<11>},
+    {TIM2_IRQn, mHandleTimerEvent<2>},
+    {TIM3_IRQn, mHandleTimerEvent<3>},
+    {TIM4_IRQn, mHandleTimerEvent<4>},
+    {TIM5_IRQn, mHandleTimerEvent<5>},
+    {TIM6_DAC_IRQn, mHandleTimerEvent<6>},
+    {TIM7_IRQn, mHandleTimerEvent<7>},
+    {TIM8_UP_TIM13_IRQn, mHandleTimerEvent<8, 13>},
+    {TIM8_CC_IRQn, mHandleTimerEvent<8>},
+    {TIM8_BRK_TIM12_IRQn, mHandleTimerEvent<12>},
+    {TIM8_TRG_COM_TIM14_IRQn, mHandleTimerEvent<14>},
+}};
+
 
 /*******************************************************************************
  * EXTERN FUNCTION IMPLEMENTATIONS
@@ -148,27 +292,28 @@ void handleError(void)
     while (1) {};
 }
 
-void handleTIM2Event(void)
+void handleUSART1Event(void)
+{
+    mHandleUartEvent(USART1, 1);
+}
+
+void handleCAN2TXEvent(void)
 {
-    mHandleTimerEvent(TIM2, 2);
+    mHandleSoftwareInterrupt(1);
 }
 
-void handleTIM5Event(void)
+void handleCAN2RX0Event(void)
 {
-    mHandleTimerEvent(TIM5, 5);
+    mHandleSoftwareInterrupt(2);
 }
 
-void handleUSART1Event(void)
+void handleCAN2RX1Event(void)
 {
-    mHandleUartEvent(USART1, 1);
+    mHandleSoftwareInterrupt(3);
 }
 
-void handleDMA2Stream7Event(void)
+void handleCAN2SCEEvent(void)
 {
-    mHandleDmaEvent(&DMA2->HISR, &DMA2->HIFCR, 2, 7, Stm32f750Dma::TCIFx(7),
-                    Stm32f750Dma::CTCIFx(7), Stm32f750Dma::TEIFx(7),
-                    Stm32f750Dma::CTEIFx(7), Stm32f750Dma::DMEIFx(7),
-                    Stm32f750Dma::CDMEIFx(7), Stm32f750Dma::FEIFx(7),
-                    Stm32f750Dma::CFEIFx(7));
+    mHandleSoftwareInterrupt(4);
 }
 }
@@ -12,6 +12,7 @@
  * INCLUDE DIRECTIVES
  ******************************************************************************/
 
+#include <array>
 #include <device/irqs.hpp>
 #include <hardware/mcu.hpp>
 
@@ -28,11 +29,41 @@ namespace device
  * PUBLIC TYPE DEFINITIONS
  ******************************************************************************/
 
+/** IRQ line of a DMA stream & its handler */
+struct DmaStreamIrq {
+    IRQn_Type irq_nb;
+    InterruptHandler handler;
+};
+
+/** IRQ line of one or two timers & its handler */
+struct TimerIrq {
+    IRQn_Type irq_nb;
+    InterruptHandler handler;
+};
+
 
 /*******************************************************************************
  * EXTERN CONSTANT DECLARATIONS
  ******************************************************************************/
 
+/* Both DMA controllers have 8 streams */
+constexpr unsigned nb_dma_stream_irqs = 16;
+
+/** Handlers of every DMA stream, to be installed in the vector table. Each one
+ * dispatches the events of its stream to the matching DMA device. */
+extern const std::array<DmaStreamIrq, nb_dma_stream_irqs> dma_stream_irqs;
+
+/* TIM1 & TIM8 raise their update and capture/compare interrupts on distinct
+ * lines, TIM9 to TIM14 share the other lines of TIM1 & TIM8 */
+constexpr unsigned nb_timer_irqs = 14;
+
+/** Handlers of every timer, to be installed in the vector table. Each one
+ * dispatches the events of the timers of its line to the matching timer
+ * devices, timers that were not built are skipped. Timers sharing a line are
+ * also masked together by the critical sections of their drivers, which must
+ * then not preempt each other. */
+extern const std::array<TimerIrq, nb_timer_irqs> timer_irqs;
+
 extern "C" {
 
 
@@ -40,10 +71,12 @@ extern "C" {
  * EXTERN FUNCTION DECLARATIONS
  ******************************************************************************/
 
-void handleTIM2Event(void);
-void handleTIM5Event(void);
 void handleUSART1Event(void);
-void handleDMA2Stream7Event(void);
+/* Software interrupts of the interrupt executors */
+void handleCAN2TXEvent(void);
+void handleCAN2RX0Event(void);
+void handleCAN2RX1Event(void);
+void handleCAN2SCEEvent(void);
 }
 }  // namespace device
 }  // namespace hal
@@ -0,0 +1,203 @@
+/*******************************************************************************
+ * Implementation file for the PWM outputs of STM32F750 timers
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "stm32f750_pwm.hpp"
+
+#include "stm32f750_timer.hpp"
+
+#include <device/exceptions/timer_exceptions.hpp>
+#include <hardware/mcu.hpp>
+
+using namespace std;
+using namespace hal::device;
+
+
+/*******************************************************************************
+ * CONSTRUCTORS & DESTRUCTOR
+ ******************************************************************************/
+
+Stm32f750Pwm::Stm32f750Pwm(TIM_TypeDef* hw_timer,
+                           volatile uint32_t* clk_en_reg,
+                           uint32_t clk_en_msk,
+                           volatile uint32_t* rst_reg,
+                           uint32_t rst_msk,
+                           size_t counter_sz,
+                           size_t channel,
+                           uint32_t timer_clk_hz,
+                           uint32_t tick_hz,
+                           Stm32f750Dma& dma,
+                           unsigned dma_stream_id,
+                           unsigned dma_chan_id)
+: hw_timer{hw_timer}, clk_en_reg{clk_en_reg}, clk_en_msk{clk_en_msk},
+  max_count{static_cast<uint32_t>((1ULL << counter_sz) - 1)},
+  channel{channel}, timer_clk_hz{timer_clk_hz},
+  prescaler_div{Stm32f750Timer::computePrescalerDiv(timer_clk_hz, tick_hz)},
+  dma{dma}, dma_stream_id{dma_stream_id}
+{
+    *clk_en_reg |= clk_en_msk;
+
+    /* Disable timer while we are configuring it */
+    hw_timer->CR1 &= ~TIM_CR1_CEN;
+    /* Reset timer */
+    *rst_reg |= rst_msk;
+    *rst_reg &= ~rst_msk;
+
+    /* Increment the time counter every PSC + 1 clock ticks. The period and
+     * the duty cycle are preloaded so that they only change between two
+     * periods. */
+    hw_timer->PSC = (uint16_t)(prescaler_div - 1);
+    hw_timer->ARR = max_count - 1;
+    hw_timer->CR1 |= TIM_CR1_ARPE;
+    *CCRx() = 0;
+
+    /* Channels 1 & 2 are set in CCMR1, 3 & 4 in CCMR2, 8 bits each: PWM mode
+     * 1 keeps the output high while the counter is below the duty cycle */
+    volatile uint32_t* ccmr = (channel < 2) ? &hw_timer->CCMR1
+                                            : &hw_timer->CCMR2;
+    unsigned ccmr_shift     = 8 * (channel % 2);
+    *ccmr = (*ccmr & ~(0xFFUL << ccmr_shift))
+            | ((TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1PE)
+               << ccmr_shift);
+    hw_timer->CCER |= TIM_CCER_CC1E << (4 * channel);
+
+    /* Load the preloaded registers & start with a low output */
+    hw_timer->CR1 |= TIM_CR1_URS;
+    hw_timer->EGR = TIM_EGR_UG;
+    hw_timer->CR1 |= TIM_CR1_CEN;
+
+    dma.setChannel(dma_stream_id, dma_chan_id);
+    dma.setTransferCompleteCallback(
+        dma_stream_id,
+        [this](unsigned, size_t count, ErrorStatus&& err) {
+            dmaTransferCompleted(count, move(err));
+        });
+}
+
+Stm32f750Pwm::~Stm32f750Pwm()
+{
+    if (running) {
+        stopWaveform();
+    }
+    dma.setTransferCompleteCallback(dma_stream_id, nullptr);
+    hw_timer->CCER &= ~(TIM_CCER_CC1E << (4 * channel));
+    hw_timer->CR1 &= ~TIM_CR1_CEN;
+    *clk_en_reg &= ~clk_en_msk;
+}
+
+
+/*******************************************************************************
+ * OPERATOR IMPLEMENTATIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PRIVATE METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+volatile uint32_t* Stm32f750Pwm::CCRx()
+{
+    /* CCR1 to CCR4 follow each other */
+    return &(&hw_timer->CCR1)[channel];
+}
+
+void Stm32f750Pwm::dmaTransferCompleted(size_t count, ErrorStatus&& err)
+{
+    if (!running) {
+        return;
+    }
+
+    /* The DMA disables the stream once a regular transfer is done or on
+     * error. The timer keeps running with the last duty cycle. */
+    if (!circular || err) {
+        running = false;
+        hw_timer->DIER &= ~TIM_DIER_UDE;
+    }
+
+    if (waveform_callback) {
+        waveform_callback(count / sizeof(uint32_t), move(err));
+    }
+}
+
+/*******************************************************************************
+ * PROTECTED METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PUBLIC METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+TimerDevice::TickRate Stm32f750Pwm::getTickRate() const
+{
+    return TimerDevice::TickRate{timer_clk_hz, prescaler_div};
+}
+
+uint32_t Stm32f750Pwm::getMaxPeriod() const
+{
+    return max_count;
+}
+
+void Stm32f750Pwm::setPeriod(uint32_t period)
+{
+    if (period == 0 || period > max_count) {
+        throw InvalidTimerCountException{period, max_count};
+    }
+
+    /* The counter counts from 0 to ARR included */
+    hw_timer->ARR = period - 1;
+}
+
+uint32_t Stm32f750Pwm::getPeriod() const
+{
+    return hw_timer->ARR + 1;
+}
+
+void Stm32f750Pwm::setDutyCycle(uint32_t duty_cycle)
+{
+    *CCRx() = duty_cycle;
+}
+
+void Stm32f750Pwm::startWaveform(const uint32_t* duty_cycles,
+                                 size_t nb_duty_cycles,
+                                 bool circular)
+{
+    if (running) {
+        stopWaveform();
+    }
+
+    /* Each update event, i.e. the start of each period, requests the duty
+     * cycle of the following period */
+    DmaDevice::Location src = {reinterpret_cast<uintptr_t>(duty_cycles),
+                               DmaDevice::DataWidth::Word, true};
+    DmaDevice::Location dst = {reinterpret_cast<uintptr_t>(CCRx()),
+                               DmaDevice::DataWidth::Word, false};
+
+    this->circular = circular;
+    if (circular) {
+        dma.startCircularTransfer(dma_stream_id, src, dst,
+                                  nb_duty_cycles * sizeof(uint32_t),
+                                  DmaDevice::TransferDirection::MemToPeriph,
+                                  DmaDevice::TransferPriority::VeryHigh);
+    } else {
+        dma.startTransfer(dma_stream_id, src, dst,
+                          nb_duty_cycles * sizeof(uint32_t),
+                          DmaDevice::TransferDirection::MemToPeriph,
+                          DmaDevice::TransferPriority::VeryHigh);
+    }
+    running = true;
+
+    hw_timer->DIER |= TIM_DIER_UDE;
+}
+
+void Stm32f750Pwm::stopWaveform()
+{
+    /* The DMA reports the cancellation, it must be ignored */
+    running = false;
+
+    hw_timer->DIER &= ~TIM_DIER_UDE;
+    dma.cancelTransfer(dma_stream_id);
+    *CCRx() = 0;
+}
@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * Interface file for the PWM outputs of STM32F750 timers. Duty cycles are
+ * moved from memory to the compare register by a DMA stream on each update
+ * event so that the CPU is not involved at each period.
+ ******************************************************************************/
+
+#ifndef _HAL_DEVICE_STM32F750_PWM_HPP
+#define _HAL_DEVICE_STM32F750_PWM_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "stm32f750_dma.hpp"
+
+#include <cstdint>
+#include <device/pwm_device.hpp>
+#include <hardware/mcu.hpp>
+
+namespace hal
+{
+namespace device
+{
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+class Stm32f750Pwm : public PwmDevice
+{
+  public:
+    /** Construct a PWM object for the STM32F750 MCU. The timer will be reset
+     * and fully owned by this object, its output starts low.
+     * /!\ This call will not configure GPIOs.
+     * @param channel
+     *  The capture/compare channel of the timer, channel 0 is the hardware
+     * channel 1
+     * @param dma_stream_id
+     * @param dma_chan_id
+     *  The DMA stream & channel receiving the update requests of the timer
+     * (cf reference manual) */
+    Stm32f750Pwm(TIM_TypeDef* hw_timer,
+                 volatile uint32_t* clk_en_reg,
+                 uint32_t clk_en_msk,
+                 volatile uint32_t* rst_reg,
+                 uint32_t rst_msk,
+                 size_t counter_sz,
+                 size_t channel,
+                 uint32_t timer_clk_hz,
+                 uint32_t tick_hz,
+                 Stm32f750Dma& dma,
+                 unsigned dma_stream_id,
+                 unsigned dma_chan_id);
+    ~Stm32f750Pwm();
+
+    TimerDevice::TickRate getTickRate() const override;
+    uint32_t getMaxPeriod() const override;
+    void setPeriod(uint32_t period) override;
+    uint32_t getPeriod() const override;
+    void setDutyCycle(uint32_t duty_cycle) override;
+
+    void startWaveform(const uint32_t* duty_cycles,
+                       size_t nb_duty_cycles,
+                       bool circular) override;
+    void stopWaveform() override;
+
+  private:
+    TIM_TypeDef* const hw_timer;
+
+    volatile uint32_t* const clk_en_reg;
+    const uint32_t clk_en_msk;
+
+    const uint32_t max_count;
+    const size_t channel;
+    const uint32_t timer_clk_hz;
+    const uint32_t prescaler_div;
+
+    Stm32f750Dma& dma;
+    const unsigned dma_stream_id;
+
+    bool running  = false;
+    bool circular = false;
+
+    volatile uint32_t* CCRx();
+
+    void dmaTransferCompleted(size_t count, ErrorStatus&& err);
+};
+
+}  // namespace device
+}  // namespace hal
+
+#endif
@@ -8,6 +8,8 @@
  ******************************************************************************/
 
 #include "stm32f750_dma.hpp"
+#include "stm32f750_input_capture.hpp"
+#include "stm32f750_pwm.hpp"
 #include "stm32f750_timer.hpp"
 #include "stm32f750_uart.hpp"
 #include "stm32f750_uart_with_dma.hpp"
@@ -69,11 +71,15 @@ System& System::getInstance()
     return s;
 }
 
-TimerDevice& System::getTimer(unsigned id)
+TimerDevice& System::getTimer(unsigned id, uint32_t tick_hz)
 {
     if (id < 1 || id > nb_timers) {
         throw InvalidTimerIdException(id);
     }
+    if (tick_hz == 0
+        || (timers[id - 1] != nullptr && timer_tick_hz[id - 1] != tick_hz)) {
+        throw InvalidTimerTickRateException(id, tick_hz);
+    }
 
     /* IDs start at 1
      * Timer objects are not constructed at startup but only when they are
@@ -82,83 +88,102 @@ TimerDevice& System::getTimer(unsigned id)
         switch (id) {
             case 1:
                 timers[0] = make_unique<Stm32f750Timer>(
-                    TIM1, TIM1_CC_IRQn, &RCC->APB2ENR, RCC_APB2ENR_TIM1EN,
-                    &RCC->APB2RSTR, RCC_APB2RSTR_TIM1RST, 16);
+                    TIM1, TIM1_UP_TIM10_IRQn, TIM1_CC_IRQn, &RCC->APB2ENR,
+                    RCC_APB2ENR_TIM1EN, &RCC->APB2RSTR, RCC_APB2RSTR_TIM1RST,
+                    16, 4, apb2_timer_clk_hz, tick_hz);
                 break;
             case 2:
                 timers[1] = make_unique<Stm32f750Timer>(
-                    TIM2, TIM2_IRQn, &RCC->APB1ENR, RCC_APB1ENR_TIM2EN,
-                    &RCC->APB1RSTR, RCC_APB1RSTR_TIM2RST, 32);
+                    TIM2, TIM2_IRQn, TIM2_IRQn, &RCC->APB1ENR,
+                    RCC_APB1ENR_TIM2EN, &RCC->APB1RSTR, RCC_APB1RSTR_TIM2RST,
+                    32, 4, apb1_timer_clk_hz, tick_hz);
                 break;
             case 3:
                 timers[2] = make_unique<Stm32f750Timer>(
-                    TIM3, TIM3_IRQn, &RCC->APB1ENR, RCC_APB1ENR_TIM3EN,
-                    &RCC->APB1RSTR, RCC_APB1RSTR_TIM3RST, 16);
+                    TIM3, TIM3_IRQn, TIM3_IRQn, &RCC->APB1ENR,
+                    RCC_APB1ENR_TIM3EN, &RCC->APB1RSTR, RCC_APB1RSTR_TIM3RST,
+                    16, 4, apb1_timer_clk_hz, tick_hz);
                 break;
             case 4:
                 timers[3] = make_unique<Stm32f750Timer>(
-                    TIM4, TIM4_IRQn, &RCC->APB1ENR, RCC_APB1ENR_TIM4EN,
-                    &RCC->APB1RSTR, RCC_APB1RSTR_TIM4RST, 16);
+                    TIM4, TIM4_IRQn, TIM4_IRQn, &RCC->APB1ENR,
+                    RCC_APB1ENR_TIM4EN, &RCC->APB1RSTR, RCC_APB1RSTR_TIM4RST,
+                    16, 4, apb1_timer_clk_hz, tick_hz);
                 break;
             case 5:
                 timers[4] = make_unique<Stm32f750Timer>(
-                    TIM5, TIM5_IRQn, &RCC->APB1ENR, RCC_APB1ENR_TIM5EN,
-                    &RCC->APB1RSTR, RCC_APB1RSTR_TIM5RST, 32);
+                    TIM5, TIM5_IRQn, TIM5_IRQn, &RCC->APB1ENR,
+                    RCC_APB1ENR_TIM5EN, &RCC->APB1RSTR, RCC_APB1RSTR_TIM5RST,
+                    32, 4, apb1_timer_clk_hz, tick_hz);
                 break;
             case 6:
                 timers[5] = make_unique<Stm32f750Timer>(
-                    TIM6, TIM6_DAC_IRQn, &RCC->APB1ENR, RCC_APB1ENR_TIM6EN,
-                    &RCC->APB1RSTR, RCC_APB1RSTR_TIM6RST, 16);
+                    TIM6, TIM6_DAC_IRQn, TIM6_DAC_IRQn, &RCC->APB1ENR,
+                    RCC_APB1ENR_TIM6EN, &RCC->APB1RSTR, RCC_APB1RSTR_TIM6RST,
+                    16, 0, apb1_timer_clk_hz, tick_hz);
                 break;
             case 7:
                 timers[6] = make_unique<Stm32f750Timer>(
-                    TIM7, TIM7_IRQn, &RCC->APB1ENR, RCC_APB1ENR_TIM7EN,
-                    &RCC->APB1RSTR, RCC_APB1RSTR_TIM7RST, 16);
+                    TIM7, TIM7_IRQn, TIM7_IRQn, &RCC->APB1ENR,
+                    RCC_APB1ENR_TIM7EN, &RCC->APB1RSTR, RCC_APB1RSTR_TIM7RST,
+                    16, 0, apb1_timer_clk_hz, tick_hz);
                 break;
             case 8:
                 timers[7] = make_unique<Stm32f750Timer>(
-                    TIM8, TIM8_CC_IRQn, &RCC->APB2ENR, RCC_APB2ENR_TIM8EN,
-                    &RCC->APB2RSTR, RCC_APB2RSTR_TIM8RST, 16);
+                    TIM8, TIM8_UP_TIM13_IRQn, TIM8_CC_IRQn, &RCC->APB2ENR,
+                    RCC_APB2ENR_TIM8EN, &RCC->APB2RSTR, RCC_APB2RSTR_TIM8RST,
+                    16, 4, apb2_timer_clk_hz, tick_hz);
                 break;
             case 9:
                 timers[8] = make_unique<Stm32f750Timer>(
-                    TIM9, TIM1_BRK_TIM9_IRQn, &RCC->APB2ENR, RCC_APB2ENR_TIM9EN,
-                    &RCC->APB2RSTR, RCC_APB2RSTR_TIM9RST, 16);
+                    TIM9, TIM1_BRK_TIM9_IRQn, TIM1_BRK_TIM9_IRQn, &RCC->APB2ENR,
+                    RCC_APB2ENR_TIM9EN, &RCC->APB2RSTR, RCC_APB2RSTR_TIM9RST,
+                    16, 2, apb2_timer_clk_hz, tick_hz);
                 break;
             case 10:
                 timers[9] = make_unique<Stm32f750Timer>(
-                    TIM10, TIM1_UP_TIM10_IRQn, &RCC->APB2ENR,
-                    RCC_APB2ENR_TIM10EN, &RCC->APB2RSTR, RCC_APB2RSTR_TIM10RST,
-                    16);
+                    TIM10, TIM1_UP_TIM10_IRQn, TIM1_UP_TIM10_IRQn,
+                    &RCC->APB2ENR, RCC_APB2ENR_TIM10EN, &RCC->APB2RSTR,
+                    RCC_APB2RSTR_TIM10RST, 16, 1, apb2_timer_clk_hz, tick_hz);
                 break;
             case 11:
                 timers[10] = make_unique<Stm32f750Timer>(
-                    TIM11, TIM1_TRG_COM_TIM11_IRQn, &RCC->APB2ENR,
-                    RCC_APB2ENR_TIM11EN, &RCC->APB2RSTR, RCC_APB2RSTR_TIM11RST,
-                    16);
+                    TIM11, TIM1_TRG_COM_TIM11_IRQn, TIM1_TRG_COM_TIM11_IRQn,
+                    &RCC->APB2ENR, RCC_APB2ENR_TIM11EN, &RCC->APB2RSTR,
+                    RCC_APB2RSTR_TIM11RST, 16, 1, apb2_timer_clk_hz, tick_hz);
                 break;
             case 12:
                 timers[11] = make_unique<Stm32f750Timer>(
-                    TIM12, TIM8_BRK_TIM12_IRQn, &RCC->APB1ENR,
-                    RCC_APB1ENR_TIM12EN, &RCC->APB1RSTR, RCC_APB1RSTR_TIM12RST,
-                    16);
+                    TIM12, TIM8_BRK_TIM12_IRQn, TIM8_BRK_TIM12_IRQn,
+                    &RCC->APB1ENR, RCC_APB1ENR_TIM12EN, &RCC->APB1RSTR,
+                    RCC_APB1RSTR_TIM12RST, 16, 2, apb1_timer_clk_hz, tick_hz);
                 break;
             case 13:
                 timers[12] = make_unique<Stm32f750Timer>(
-                    TIM13, TIM8_UP_TIM13_IRQn, &RCC->APB1ENR,
-                    RCC_APB1ENR_TIM13EN, &RCC->APB1RSTR, RCC_APB1RSTR_TIM13RST,
-                    16);
+                    TIM13, TIM8_UP_TIM13_IRQn, TIM8_UP_TIM13_IRQn,
+                    &RCC->APB1ENR, RCC_APB1ENR_TIM13EN, &RCC->APB1RSTR,
+                    RCC_APB1RSTR_TIM13RST, 16, 1, apb1_timer_clk_hz, tick_hz);
                 break;
             case 14:
                 timers[13] = make_unique<Stm32f750Timer>(
-                    TIM14, TIM8_TRG_COM_TIM14_IRQn, &RCC->APB1ENR,
-                    RCC_APB1ENR_TIM14EN, &RCC->APB1RSTR, RCC_APB1RSTR_TIM14RST,
-                    16);
+                    TIM14, TIM8_TRG_COM_TIM14_IRQn, TIM8_TRG_COM_TIM14_IRQn,
+                    &RCC->APB1ENR, RCC_APB1ENR_TIM14EN, &RCC->APB1RSTR,
+                    RCC_APB1RSTR_TIM14RST, 16, 1, apb1_timer_clk_hz, tick_hz);
                 break;
 
             default:
                 throw InvalidTimerIdException(id);
         }
+        timer_tick_hz[id - 1] = tick_hz;
+    }
+
+    return *timers[id - 1];
+}
+
+TimerDevice& System::getTimerDevice(unsigned id)
+{
+    if (id < 1 || id > nb_timers || timers[id - 1] == nullptr) {
+        throw InvalidTimerIdException(id);
     }
 
     return *timers[id - 1];
@@ -319,8 +344,9 @@ CharacterDevice<char>& System::getUartWithDma(unsigned id)
                                       SelFunc::Alt7, PinSpeed::Medium);
 
                 uarts_with_dma[0] = make_unique<Stm32f750UartWithDma>(
-                    USART1, &RCC->APB2ENR, RCC_APB2ENR_USART1EN, uart_baudrate,
-                    static_cast<Stm32f750Dma&>(getDma(2)), 5, 4, 7, 4);
+                    USART1, USART1_IRQn, &RCC->APB2ENR, RCC_APB2ENR_USART1EN,
+                    uart_baudrate, static_cast<Stm32f750Dma&>(getDma(2)), 5, 4,
+                    7, 4);
                 break;
             case 2:
                 /* TODO: GPIO setup */
@@ -359,7 +385,123 @@ CharacterDevice<char>& System::getUartWithDma(unsigned id)
     return *uarts_with_dma[id - 1];
 }
 
+InputCaptureDevice& System::getInputCapture(unsigned id, uint32_t tick_hz)
+{
+    if (id < 1 || id > nb_timers) {
+        throw InvalidTimerIdException(id);
+    }
+    if (tick_hz == 0
+        || (input_captures[id - 1] != nullptr
+            && timer_tick_hz[id - 1] != tick_hz)) {
+        throw InvalidTimerTickRateException(id, tick_hz);
+    }
+
+    /* IDs start at 1
+     * Input capture objects are not constructed at startup but only when they
+     * are requested.
+     * We must also setup the GPIOs */
+    if (input_captures[id - 1] == nullptr) {
+        switch (id) {
+            case 5:
+                RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN; /* TIM5_CH1 */
+                gpioFunctionConfigure(ARDUINO_A0_GPIO_Port, ARDUINO_A0_Pin,
+                                      SelFunc::Alt2, PinSpeed::High);
+
+                /* TIM5_CH1 requests are served by DMA1 stream 2 channel 6 */
+                input_captures[4] = make_unique<Stm32f750InputCapture>(
+                    TIM5, &RCC->APB1ENR, RCC_APB1ENR_TIM5EN, &RCC->APB1RSTR,
+                    RCC_APB1RSTR_TIM5RST, 32, 0, apb1_timer_clk_hz, tick_hz,
+                    static_cast<Stm32f750Dma&>(getDma(1)), 2, 6);
+                break;
+
+            default:
+                throw UnimplementedDeviceException(
+                    "TIM" + to_string(id) + " input capture");
+        }
+        timer_tick_hz[id - 1] = tick_hz;
+    }
+
+    return *input_captures[id - 1];
+}
+
+PwmDevice& System::getPwm(unsigned id, uint32_t tick_hz)
+{
+    if (id < 1 || id > nb_timers) {
+        throw InvalidTimerIdException(id);
+    }
+    if (tick_hz == 0
+        || (pwms[id - 1] != nullptr && timer_tick_hz[id - 1] != tick_hz)) {
+        throw InvalidTimerTickRateException(id, tick_hz);
+    }
+
+    /* IDs start at 1
+     * PWM objects are not constructed at startup but only when they are
+     * requested.
+     * We must also setup the GPIOs */
+    if (pwms[id - 1] == nullptr) {
+        switch (id) {
+            case 2:
+                RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN; /* TIM2_CH1 */
+                gpioFunctionConfigure(ARDUINO_PWM_D9_GPIO_Port,
+                                      ARDUINO_PWM_D9_Pin, SelFunc::Alt1,
+                                      PinSpeed::High);
+
+                /* TIM2_UP requests are served by DMA1 stream 1 channel 3 */
+                pwms[1] = make_unique<Stm32f750Pwm>(
+                    TIM2, &RCC->APB1ENR, RCC_APB1ENR_TIM2EN, &RCC->APB1RSTR,
+                    RCC_APB1RSTR_TIM2RST, 32, 0, apb1_timer_clk_hz, tick_hz,
+                    static_cast<Stm32f750Dma&>(getDma(1)), 1, 3);
+                break;
+
+            default:
+                throw UnimplementedDeviceException("TIM" + to_string(id)
+                                                   + " PWM");
+        }
+        timer_tick_hz[id - 1] = tick_hz;
+    }
+
+    return *pwms[id - 1];
+}
+
 EventLoop& System::getEventLoop()
 {
     return event_loop;
 }
+
+InterruptExecutor& System::getInterruptExecutor(unsigned id)
+{
+    if (id < 1 || id > nb_interrupt_executors) {
+        throw InvalidInterruptExecutorIdException(id);
+    }
+
+    /* IDs start at 1
+     * CAN2 is not driven by this HAL so its IRQ lines are free to be
+     * triggered by software. */
+    constexpr uint32_t lowest_nvic_priority = (1UL << __NVIC_PRIO_BITS) - 1;
+
+    if (interrupt_executors[id - 1] == nullptr) {
+        switch (id) {
+            case 1:
+                interrupt_executors[0] = make_unique<InterruptExecutor>(
+                    CAN2_TX_IRQn, lowest_nvic_priority - 1);
+                break;
+            case 2:
+                interrupt_executors[1] = make_unique<InterruptExecutor>(
+                    CAN2_RX0_IRQn, lowest_nvic_priority - 2);
+                break;
+            case 3:
+                interrupt_executors[2] = make_unique<InterruptExecutor>(
+                    CAN2_RX1_IRQn, lowest_nvic_priority - 3);
+                break;
+            case 4:
+                interrupt_executors[3] = make_unique<InterruptExecutor>(
+                    CAN2_SCE_IRQn, lowest_nvic_priority - 4);
+                break;
+
+            default:
+                throw InvalidInterruptExecutorIdException(id);
+        }
+    }
+
+    return *interrupt_executors[id - 1];
+}
@@ -9,7 +9,9 @@
 
 #include "stm32f750_timer.hpp"
 
+#include <algorithm>
 #include <device/exceptions/timer_exceptions.hpp>
+#include <device/irqs.hpp>
 #include <hardware/mcu.hpp>
 
 using namespace std;
@@ -22,16 +24,26 @@ using namespace hal::device;
 
 Stm32f750Timer::Stm32f750Timer(TIM_TypeDef* hw_timer,
                                IRQn_Type irq_nb,
+                               IRQn_Type cc_irq_nb,
                                volatile uint32_t* clk_en_reg,
                                uint32_t clk_en_msk,
                                volatile uint32_t* rst_reg,
                                uint32_t rst_msk,
-                               size_t counter_sz)
-: hw_timer{hw_timer}, irq_nb{irq_nb}, clk_en_reg{clk_en_reg},
-  clk_en_msk{clk_en_msk}, rst_reg{rst_reg}, rst_msk{rst_msk},
-  max_count{(2UL << counter_sz) - 1UL}
+                               size_t counter_sz,
+                               size_t nb_channels,
+                               uint32_t timer_clk_hz,
+                               uint32_t tick_hz)
+: hw_timer{hw_timer}, irq_nb{irq_nb}, cc_irq_nb{cc_irq_nb},
+  clk_en_reg{clk_en_reg}, clk_en_msk{clk_en_msk}, rst_reg{rst_reg},
+  rst_msk{rst_msk},
+  counter_sz{counter_sz},
+  max_count{static_cast<TickCount>((1ULL << counter_sz) - 1)},
+  timer_clk_hz{timer_clk_hz},
+  prescaler_div{computePrescalerDiv(timer_clk_hz, tick_hz)},
+  nb_channels{nb_channels}
 {
     NVIC_SetPriority(irq_nb, 0);
+    NVIC_SetPriority(cc_irq_nb, 0);
     *clk_en_reg |= clk_en_msk;
 
     /* Disable timer while we are configuring it */
@@ -41,15 +53,16 @@ Stm32f750Timer::Stm32f750Timer(TIM_TypeDef* hw_timer,
     *rst_reg &= ~rst_msk;
 
     /* Increment the time counter every PSC + 1 clock ticks */
-    hw_timer->PSC = (uint16_t)(core_clk_hz / ck_cnt - 1);
+    hw_timer->PSC = (uint16_t)(prescaler_div - 1);
     /* Enable IRQ generation based on TIM2 events */
     hw_timer->DIER |= TIM_DIER_UIE;
 }
 
 Stm32f750Timer::~Stm32f750Timer()
 {
-    NVIC_DisableIRQ(irq_nb);
-    hw_timer->DIER &= ~TIM_DIER_UIE;
+    /* The IRQ lines are left enabled, they may be shared with other timers */
+    hw_timer->DIER &= ~(TIM_DIER_UIE | TIM_DIER_CC1IE | TIM_DIER_CC2IE
+                        | TIM_DIER_CC3IE | TIM_DIER_CC4IE);
     hw_timer->CR1 &= ~TIM_CR1_CEN;
     *clk_en_reg &= ~clk_en_msk;
 }
@@ -63,6 +76,40 @@ Stm32f750Timer::~Stm32f750Timer()
  * PRIVATE METHOD IMPLEMENTATIONS
  ******************************************************************************/
 
+void Stm32f750Timer::armCompare(size_t channel)
+{
+    Deadline& deadline = deadlines[channel];
+
+    /* CCR1 to CCR4 follow each other, as do their flags in SR, DIER & EGR */
+    deadline.pending = false;
+    (&hw_timer->CCR1)[channel] =
+        static_cast<uint32_t>(deadline.value & max_count);
+    hw_timer->SR = ~(TIM_SR_CC1IF << channel);
+    hw_timer->DIER |= TIM_DIER_CC1IE << channel;
+
+    /* The counter may have gone past the deadline before the compare register
+     * was written, in which case the match is generated by software */
+    if (getCounter() >= deadline.value) {
+        hw_timer->EGR = TIM_EGR_CC1G << channel;
+    }
+}
+
+void Stm32f750Timer::enableIrqs()
+{
+    NVIC_EnableIRQ(irq_nb);
+    if (cc_irq_nb != irq_nb) {
+        NVIC_EnableIRQ(cc_irq_nb);
+    }
+}
+
+void Stm32f750Timer::disableIrqs()
+{
+    NVIC_DisableIRQ(irq_nb);
+    if (cc_irq_nb != irq_nb) {
+        NVIC_DisableIRQ(cc_irq_nb);
+    }
+}
+
 /*******************************************************************************
  * PROTECTED METHOD IMPLEMENTATIONS
  ******************************************************************************/
@@ -71,13 +118,38 @@ Stm32f750Timer::~Stm32f750Timer()
  * PUBLIC METHOD IMPLEMENTATIONS
  ******************************************************************************/
 
-TimerDevice::WaitTimeUnitDuration Stm32f750Timer::getRemainingWaitTime()
+uint32_t Stm32f750Timer::computePrescalerDiv(uint32_t timer_clk_hz,
+                                            uint32_t tick_hz)
+{
+    uint32_t div = (timer_clk_hz + tick_hz / 2) / tick_hz;
+
+    return clamp<uint32_t>(div, 1, 65536);
+}
+
+TimerDevice::TickCount Stm32f750Timer::getRemainingWaitTime()
+{
+    /* The counter is reset once the timer went off, the interrupt may still be
+     * pending if it is masked */
+    if (hw_timer->SR & TIM_SR_UIF) {
+        return 0;
+    }
+
+    return programmed_count - hw_timer->CNT;
+}
+
+TimerDevice::TickCount Stm32f750Timer::getMaxWaitCount() const
+{
+    return max_count;
+}
+
+TimerDevice::TickRate Stm32f750Timer::getTickRate() const
 {
-    return TimerDevice::WaitTimeUnitDuration{programmed_count - hw_timer->CNT};
+    return TickRate{timer_clk_hz, prescaler_div};
 }
 
-void Stm32f750Timer::usleep(WaitTimeUnitDuration::rep count)
+void Stm32f750Timer::usleep(uint32_t us)
 {
+    uint64_t count = getTickRate().fromNanoseconds(us * 1000ULL, true);
     if (count > max_count) {
         throw InvalidTimerCountException{count, max_count};
     }
@@ -99,13 +171,13 @@ void Stm32f750Timer::usleep(WaitTimeUnitDuration::rep count)
     hw_timer->SR &= ~TIM_SR_UIF;
 }
 
-bool Stm32f750Timer::startWait(WaitTimeUnitDuration::rep count)
+bool Stm32f750Timer::startWait(TickCount count)
 {
     if (count > max_count) {
         throw InvalidTimerCountException{count, max_count};
     }
 
-    NVIC_EnableIRQ(irq_nb);
+    enableIrqs();
     /* Set the event period:
      * A timer event is generated when the counter is equal to ARR */
     hw_timer->ARR    = count;
@@ -115,6 +187,8 @@ bool Stm32f750Timer::startWait(WaitTimeUnitDuration::rep count)
     hw_timer->CR1 |= TIM_CR1_OPM | TIM_CR1_URS;
     /* Reset the counter and apply new config */
     hw_timer->EGR |= TIM_EGR_UG;
+    /* Discard any previous wait that went off while the IRQ was masked */
+    hw_timer->SR = ~TIM_SR_UIF;
     /* Enable timer */
     hw_timer->CR1 |= TIM_CR1_CEN;
 
@@ -123,37 +197,155 @@ bool Stm32f750Timer::startWait(WaitTimeUnitDuration::rep count)
 
 bool Stm32f750Timer::suspendWait()
 {
-    hw_timer->CR1 &= ~TIM_CR1_CEN;
-    NVIC_DisableIRQ(irq_nb);
+    /* Only the interrupt is masked, the counter keeps on running so that the
+     * wait still goes off on time. If it does meanwhile, UIF stays set and
+     * the interrupt is taken once resumed */
+    disableIrqs();
 
     return true;
 }
 
 bool Stm32f750Timer::cancelWait()
 {
-    /* Nothing to do in particular aside from suspending, settings will be
-     * erased by next startWait() call */
+    /* Nothing to do in particular aside from stopping the counter, settings
+     * will be erased by next startWait() call. The IRQ line is left enabled,
+     * it may be shared with another timer. */
     hw_timer->CR1 &= ~TIM_CR1_CEN;
-    NVIC_DisableIRQ(irq_nb);
 
     return true;
 }
 
 bool Stm32f750Timer::resumeWait()
 {
-    NVIC_EnableIRQ(irq_nb);
-    hw_timer->CR1 |= TIM_CR1_CEN;
+    enableIrqs();
 
     return true;
 }
 
 bool Stm32f750Timer::onUpdateInterrupt()
 {
-    /* No need to disable the timer as we've set TIM_CR1_OPM, IRQ is cleared by
-     * IRQ handler */
+    if (free_running) {
+        /* getCounter() may run from a higher priority interrupt, it must
+         * never see the flag cleared while the overflow is not counted yet */
+        disableInterrupts();
+        hw_timer->SR = ~TIM_SR_UIF;
+        ++nb_overflows;
+        enableInterrupts();
+
+        for (size_t channel = 0; channel < deadlines.size(); ++channel) {
+            if (deadlines[channel].pending
+                && (deadlines[channel].value >> counter_sz) <= nb_overflows) {
+                armCompare(channel);
+            }
+        }
+
+        return true;
+    }
+
+    /* No need to disable the timer as we've set TIM_CR1_OPM. Status flags are
+     * cleared by writing 0 and writing 1 has no effect. */
+    hw_timer->SR = ~TIM_SR_UIF;
+    if (wait_complete_callback) {
+        wait_complete_callback(ErrorStatus{ErrorCode::Success});
+    }
+
+    return true;
+}
+
+bool Stm32f750Timer::onCaptureCompareInterrupt(size_t channel)
+{
+    /* Deadlines are one-shot, IRQ is cleared by IRQ handler */
+    hw_timer->DIER &= ~(TIM_DIER_CC1IE << channel);
     if (wait_complete_callback) {
         wait_complete_callback(ErrorStatus{ErrorCode::Success});
     }
 
     return true;
 }
+
+void Stm32f750Timer::startFreeRunning()
+{
+    if (nb_channels == 0) {
+        throw UnsupportedDeviceOperation{"startFreeRunning"};
+    }
+    /* The counter may be shared, e.g. between the SteadyClock and a
+     * TimerDriver, it must not be restarted */
+    if (free_running) {
+        return;
+    }
+
+    hw_timer->CR1 &= ~TIM_CR1_CEN;
+    free_running = true;
+    nb_overflows = 0;
+    for (Deadline& deadline : deadlines) { deadline.pending = false; }
+
+    /* Count over the whole counter range and keep counting on overflow */
+    hw_timer->ARR = max_count;
+    hw_timer->CR1 &= ~TIM_CR1_OPM;
+    hw_timer->CR1 |= TIM_CR1_URS;
+    /* Reset the counter and apply new config */
+    hw_timer->EGR  = TIM_EGR_UG;
+    hw_timer->SR   = 0;
+    hw_timer->DIER = (hw_timer->DIER
+                      & ~(TIM_DIER_CC1IE | TIM_DIER_CC2IE | TIM_DIER_CC3IE
+                          | TIM_DIER_CC4IE))
+                     | TIM_DIER_UIE;
+
+    enableIrqs();
+    hw_timer->CR1 |= TIM_CR1_CEN;
+}
+
+uint64_t Stm32f750Timer::getCounter()
+{
+    uint32_t overflows;
+    uint32_t count;
+    bool overflow_pending;
+
+    /* Retry if the overflow IRQ ran while we were reading */
+    do {
+        overflows        = nb_overflows;
+        count            = hw_timer->CNT;
+        overflow_pending = hw_timer->SR & TIM_SR_UIF;
+    } while (overflows != nb_overflows);
+
+    /* The counter wrapped around but the overflow IRQ is masked or has yet to
+     * run */
+    if (overflow_pending && count < max_count / 2) {
+        ++overflows;
+    }
+
+    return (static_cast<uint64_t>(overflows) << counter_sz) | count;
+}
+
+size_t Stm32f750Timer::getNbDeadlineChannels() const
+{
+    return min(nb_channels, max_nb_deadline_channels);
+}
+
+void Stm32f750Timer::setDeadline(size_t channel, uint64_t deadline)
+{
+    if (channel >= getNbDeadlineChannels()) {
+        throw UnsupportedDeviceOperation{"setDeadline"};
+    }
+
+    hw_timer->DIER &= ~(TIM_DIER_CC1IE << channel);
+    deadlines[channel].value = deadline;
+
+    if ((deadline >> counter_sz) > (getCounter() >> counter_sz)) {
+        /* The compare register only holds the lower bits of the deadline */
+        deadlines[channel].pending = true;
+    } else {
+        armCompare(channel);
+    }
+}
+
+void Stm32f750Timer::clearDeadline(size_t channel)
+{
+    if (channel >= getNbDeadlineChannels()) {
+        throw UnsupportedDeviceOperation{"clearDeadline"};
+    }
+
+    deadlines[channel].pending = false;
+    hw_timer->DIER &= ~(TIM_DIER_CC1IE << channel);
+    hw_timer->SR = ~(TIM_SR_CC1IF << channel);
+}
@@ -10,11 +10,11 @@
  * INCLUDE DIRECTIVES
  ******************************************************************************/
 
+#include <array>
 #include <chrono>
 #include <cstdint>
 #include <device/error_status.hpp>
 #include <device/timer_device.hpp>
-#include <functional>
 #include <hardware/mcu.hpp>
 
 namespace hal
@@ -28,32 +28,58 @@ namespace device
 class Stm32f750Timer : public TimerDevice
 {
   public:
+    /** @param irq_nb
+     *  IRQ line of the update interrupt
+     * @param cc_irq_nb
+     *  IRQ line of the capture/compare interrupts, the same as irq_nb except
+     * for the advanced timers TIM1 & TIM8 */
     Stm32f750Timer(TIM_TypeDef* hw_timer,
                    IRQn_Type irq_nb,
+                   IRQn_Type cc_irq_nb,
                    volatile uint32_t* clk_en_reg,
                    uint32_t clk_en_msk,
                    volatile uint32_t* rst_reg,
                    uint32_t rst_msk,
-                   size_t counter_sz);
+                   size_t counter_sz,
+                   size_t nb_channels,
+                   uint32_t timer_clk_hz,
+                   uint32_t tick_hz);
     ~Stm32f750Timer();
 
     /** Method to be called by the IRQ handler when the update interrupt is
-     * generated (i.e. the timer goes off) */
+     * generated (i.e. the timer goes off or, in free-running mode, the counter
+     * overflows). It clears the interrupt flag. */
     bool onUpdateInterrupt();
+    /** Method to be called by the IRQ handler when the capture/compare
+     * interrupt of a channel is generated (i.e. a deadline is reached in
+     * free-running mode). Channel 0 is the hardware channel 1. */
+    bool onCaptureCompareInterrupt(size_t channel);
 
-    WaitTimeUnitDuration getRemainingWaitTime() override;
-    bool startWait(WaitTimeUnitDuration::rep count) override;
+    TickCount getRemainingWaitTime() override;
+    bool startWait(TickCount count) override;
     bool suspendWait() override;
     bool cancelWait() override;
     bool resumeWait() override;
-    void usleep(WaitTimeUnitDuration::rep count) override;
+    void usleep(uint32_t us) override;
+    TickCount getMaxWaitCount() const override;
+    TickRate getTickRate() const override;
 
-  private:
-    /* We want one tick per µs (=> CK_CNT = 1000000 Hz) */
-    const unsigned ck_cnt = 1000000;
+    void startFreeRunning() override;
+    uint64_t getCounter() override;
+    size_t getNbDeadlineChannels() const override;
+    void setDeadline(size_t channel, uint64_t deadline) override;
+    void clearDeadline(size_t channel) override;
+
+    /** Division of the timer clock by the prescaler that gives the closest
+     * reachable tick rate, the prescaler divides it by 1 to 65536. This is
+     * shared with the other devices built on STM32F750 timers. */
+    static uint32_t computePrescalerDiv(uint32_t timer_clk_hz,
+                                        uint32_t tick_hz);
 
+  private:
     TIM_TypeDef* const hw_timer;
     const IRQn_Type irq_nb;
+    const IRQn_Type cc_irq_nb;
 
     volatile uint32_t* const clk_en_reg;
     const uint32_t clk_en_msk;
@@ -61,7 +87,32 @@ class Stm32f750Timer : public TimerDevice
     volatile uint32_t* const rst_reg;
     const uint32_t rst_msk;
 
-    const WaitTimeUnitDuration::rep max_count;
+    const size_t counter_sz;
+    const TickCount max_count;
+    /* The timer clock is divided by the prescaler to get the tick rate */
+    const uint32_t timer_clk_hz;
+    const uint32_t prescaler_div;
+    /* Number of capture/compare channels, 0 for basic timers */
+    const size_t nb_channels;
+
+    /* Only channels 1 to 4 have their registers laid out contiguously */
+    static constexpr size_t max_nb_deadline_channels = 4;
+
+    struct Deadline {
+        uint64_t value = 0;
+        /* The deadline is beyond the current counter period, it will be
+         * programmed once the counter overflows */
+        bool pending = false;
+    };
+
+    bool free_running = false;
+    /* Upper bits of the free-running counter */
+    volatile uint32_t nb_overflows = 0;
+    std::array<Deadline, max_nb_deadline_channels> deadlines;
+
+    void armCompare(size_t channel);
+    void enableIrqs();
+    void disableIrqs();
 };
 
 }  // namespace device
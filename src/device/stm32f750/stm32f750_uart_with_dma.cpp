@@ -9,6 +9,7 @@
 
 #include "stm32f750_uart_with_dma.hpp"
 
+#include <device/irqs.hpp>
 #include <hardware/mcu.hpp>
 
 using namespace std;
@@ -20,6 +21,7 @@ using namespace hal::device;
  ******************************************************************************/
 
 Stm32f750UartWithDma::Stm32f750UartWithDma(USART_TypeDef* uart,
+                                           IRQn_Type irq_nb,
                                            volatile uint32_t* clk_en_reg,
                                            uint32_t clk_en_msk,
                                            uint32_t baudrate,
@@ -28,8 +30,8 @@ Stm32f750UartWithDma::Stm32f750UartWithDma(USART_TypeDef* uart,
                                            unsigned rx_chan_id,
                                            unsigned tx_stream_id,
                                            unsigned tx_chan_id)
-: uart{uart}, clk_en_reg{clk_en_reg}, clk_en_msk{clk_en_msk}, dma{dma},
-  rx_stream_id{rx_stream_id}, tx_stream_id{tx_stream_id}
+: uart{uart}, irq_nb{irq_nb}, clk_en_reg{clk_en_reg}, clk_en_msk{clk_en_msk},
+  dma{dma}, rx_stream_id{rx_stream_id}, tx_stream_id{tx_stream_id}
 {
     *clk_en_reg |= clk_en_msk;
 
@@ -43,13 +45,33 @@ Stm32f750UartWithDma::Stm32f750UartWithDma(USART_TypeDef* uart,
 
     dma.setChannel(rx_stream_id, rx_chan_id);
     dma.setChannel(tx_stream_id, tx_chan_id);
+    /* Both streams share the same handler */
     dma.setTransferCompleteCallback(
-        bind(&Stm32f750UartWithDma::dmaTransferCompleted, this,
-             placeholders::_1, placeholders::_2, placeholders::_3));
+        rx_stream_id,
+        [this](unsigned stream_id, size_t count, ErrorStatus&& err) {
+            dmaTransferCompleted(stream_id, count, move(err));
+        });
+    dma.setTransferCompleteCallback(
+        tx_stream_id,
+        [this](unsigned stream_id, size_t count, ErrorStatus&& err) {
+            dmaTransferCompleted(stream_id, count, move(err));
+        });
+
+    startReception();
+    NVIC_EnableIRQ(irq_nb);
 }
 
 Stm32f750UartWithDma::~Stm32f750UartWithDma()
 {
+    NVIC_DisableIRQ(irq_nb);
+
+    /* The DMA reports the cancellation, it must be ignored */
+    receiving = false;
+    dma.cancelTransfer(rx_stream_id);
+    dma.setTransferCompleteCallback(rx_stream_id, nullptr);
+    dma.setTransferCompleteCallback(tx_stream_id, nullptr);
+
+    uart->CR3 = 0;
     uart->CR1 = 0;
     *clk_en_reg &= ~clk_en_msk;
 }
@@ -62,19 +84,117 @@ Stm32f750UartWithDma::~Stm32f750UartWithDma()
  * PRIVATE METHOD IMPLEMENTATIONS
  ******************************************************************************/
 
+void Stm32f750UartWithDma::startReception()
+{
+    DmaDevice::Location src = {reinterpret_cast<uintptr_t>(&uart->RDR),
+                               DmaDevice::DataWidth::Byte, false};
+    DmaDevice::Location dst = {reinterpret_cast<uintptr_t>(rx_ring.data()),
+                               DmaDevice::DataWidth::Byte, true};
+
+    rx_tail       = 0;
+    idle_head     = rx_ring_size;
+    nb_received   = 0;
+    rx_event_head = 0;
+    nb_consumed   = 0;
+    rx_overrun    = false;
+
+    dma.startCircularTransfer(rx_stream_id, src, dst, rx_ring_size,
+                              DmaDevice::TransferDirection::PeriphToMem,
+                              DmaDevice::TransferPriority::VeryHigh);
+    receiving = true;
+
+    uart->ICR = USART_ICR_IDLECF;
+    uart->CR3 |= USART_CR3_DMAR;
+    uart->CR1 |= USART_CR1_UE | USART_CR1_RE | USART_CR1_IDLEIE;
+}
+
+size_t Stm32f750UartWithDma::rxHead()
+{
+    /* The remaining count is reloaded as soon as the DMA wraps around */
+    return (rx_ring_size - dma.getRemainingCount(rx_stream_id)) % rx_ring_size;
+}
+
+bool Stm32f750UartWithDma::readFromRing()
+{
+    if (nb_to_read == 0) {
+        return false;
+    }
+
+    /* The DMA is less than a whole ring buffer past its last report */
+    size_t head      = rxHead();
+    size_t nb_unread = nb_received
+                       + (head + rx_ring_size - rx_event_head) % rx_ring_size
+                       - nb_consumed;
+    if (nb_unread >= rx_ring_size) {
+        /* The DMA caught up with the unread bytes and overwrote them, they
+         * are all dropped */
+        rx_overrun = true;
+        rx_tail    = head;
+        nb_consumed += nb_unread;
+    }
+    if (rx_overrun) {
+        rx_overrun  = false;
+        nb_to_read  = 0;
+        read_status = ErrorCode::Overrun;
+        return true;
+    }
+
+    bool done = false;
+    while (!done && rx_tail != head) {
+        char c  = rx_ring[rx_tail];
+        rx_tail = (rx_tail + 1) % rx_ring_size;
+        ++nb_consumed;
+
+        buf_in[nb_read++] = c;
+        done              = (nb_read == nb_to_read) || (read_stop_char == c);
+    }
+
+    /* Nothing was received since the line went idle, there is no point in
+     * waiting for more */
+    if (head == idle_head && nb_read > 0) {
+        done = true;
+    }
+
+    if (done) {
+        nb_to_read  = 0;
+        read_status = ErrorCode::Success;
+    }
+    return done;
+}
 
 void Stm32f750UartWithDma::dmaTransferCompleted(unsigned stream_id,
                                                 size_t count,
                                                 ErrorStatus&& err)
 {
     if (stream_id == tx_stream_id) {
-        uart->CR1 &= ~USART_CR1_TE;
+        /* The transmitter stays enabled so that it does not send an idle
+         * frame when the next write is chained from the callback */
         uart->CR3 &= ~USART_CR3_DMAT;
         write_complete_callback(count, move(err));
-    } else if (stream_id == rx_stream_id) {
-        uart->CR1 &= ~USART_CR1_RE;
-        uart->CR3 &= ~USART_CR3_DMAR;
-        read_complete_callback(count, move(err));
+    } else if (stream_id == rx_stream_id && receiving) {
+        if (err) {
+            /* The DMA disabled the stream, the running read fails and
+             * reception starts over */
+            uart->CR3 &= ~USART_CR3_DMAR;
+            startReception();
+
+            if (nb_to_read != 0) {
+                nb_to_read = 0;
+                if (read_complete_callback) {
+                    read_complete_callback(nb_read, move(err));
+                }
+            }
+            return;
+        }
+
+        /* Half of the ring buffer was filled, the DMA now is at its middle
+         * or at its start */
+        nb_received += rx_ring_size / 2;
+        rx_event_head = count % rx_ring_size;
+
+        if (readFromRing() && read_complete_callback) {
+            read_complete_callback(nb_read, ErrorStatus{read_status});
+        }
     }
 }
 
@@ -116,12 +236,43 @@ void Stm32f750UartWithDma::startRead(char* buf,
                                      size_t buf_size,
                                      std::optional<char> stop_char)
 {
-    // TODO
+    /* The IRQs read from the ring buffer as soon as the read is set */
+    disableInterrupts();
+    buf_in           = buf;
+    nb_to_read       = buf_size;
+    nb_read          = 0;
+    read_stop_char   = stop_char;
+    read_status      = ErrorCode::Success;
+    bool done        = (buf_size == 0) || readFromRing();
+    ErrorCode status = read_status;
+    enableInterrupts();
+
+    if (done && read_complete_callback) {
+        read_complete_callback(nb_read, ErrorStatus{status});
+    }
 }
 
 bool Stm32f750UartWithDma::cancelRead(size_t& nb_read)
 {
-    nb_read = 0;
-    // TODO
-    return false;
+    disableInterrupts();
+    if (nb_to_read == 0) {
+        /* Nothing to cancel */
+        enableInterrupts();
+        return false;
+    }
+
+    nb_to_read = 0;
+    enableInterrupts();
+
+    nb_read = this->nb_read;
+    return true;
+}
+
+void Stm32f750UartWithDma::onIdleLine()
+{
+    idle_head = rxHead();
+
+    if (readFromRing() && read_complete_callback) {
+        read_complete_callback(nb_read, ErrorStatus{read_status});
+    }
 }
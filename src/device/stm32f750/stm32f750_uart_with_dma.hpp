@@ -2,7 +2,9 @@
 /*******************************************************************************
  * Interface file for UARTs of STM32F750 used in combination with a DMA stream
  * to offload transfers from the CPU.
- * The UART is a character device.
+ * The UART is a character device. Received bytes are continuously moved to a
+ * ring buffer by a circular DMA transfer and reads are served from it, so that
+ * no byte is lost between two reads.
  ******************************************************************************/
 
 #ifndef _HAL_DEVICE_STM32F750_UART_WITH_DMA_HPP
@@ -14,10 +16,23 @@
 
 #include "stm32f750_dma.hpp"
 
+#include <array>
 #include <cstdint>
 #include <device/character_device.hpp>
 #include <hardware/mcu.hpp>
 
+
+/*******************************************************************************
+ * MACRO DEFINITION
+ ******************************************************************************/
+
+/* Size in bytes of the reception ring buffer of each UART, it must be even.
+ * Bytes that are not read before the ring buffer wraps around are lost, the
+ * read then fails with the Overrun error. */
+#ifndef UART_DMA_RX_RING_SIZE
+    #define UART_DMA_RX_RING_SIZE 256
+#endif
+
 namespace hal
 {
 namespace device
@@ -33,8 +48,10 @@ class Stm32f750UartWithDma : public CharacterDevice<char>
      * component will be fully initialized an ready to be used.
      * /!\ This call will not configure GPIOs.
      * In addition to the regular UART, a DMA reference must be provided as well
-     * as the channels and streams ID to use for the transfers. */
+     * as the channels and streams ID to use for the transfers.
+     * Reception starts right away. */
     Stm32f750UartWithDma(USART_TypeDef* uart,
+                         IRQn_Type irq_nb,
                          volatile uint32_t* clk_en_reg,
                          uint32_t clk_en_msk,
                          uint32_t baudrate,
@@ -48,16 +65,29 @@ class Stm32f750UartWithDma : public CharacterDevice<char>
     void startWrite(const char* buf, size_t buf_size) override;
     bool cancelWrite(size_t& nb_written) override;
 
-    /** /!\ UART with DMA does not support stop characters, an
-     * @ref UnsupportedDeviceOperation will be raised if stop_char is not
-     * nullopt. */
+    /** The read also completes once the line goes idle, after at least one
+     * byte was read. Bytes received beforehand are read first, the read may
+     * thus complete before this returns.
+     * If received bytes were overwritten before being read, the running read
+     * or else the next one completes with the Overrun error and the bytes read
+     * so far. The unread bytes are dropped, reading goes on with the bytes
+     * received afterwards. */
     void startRead(char* buf,
                    size_t buf_size,
                    std::optional<char> stop_char = std::nullopt) override;
+    /** The bytes that were not read yet are kept for the next read */
     bool cancelRead(size_t& nb_read) override;
 
+    /** Must be called from the UART IRQ handler when the line goes idle,
+     * i.e. no byte was received for a whole frame */
+    void onIdleLine();
+
   private:
+    static constexpr size_t rx_ring_size = UART_DMA_RX_RING_SIZE;
+    static_assert(rx_ring_size % 2 == 0, "The ring size must be even");
+
     USART_TypeDef* const uart;
+    const IRQn_Type irq_nb;
     volatile uint32_t* const clk_en_reg;
     const uint32_t clk_en_msk;
 
@@ -65,6 +95,36 @@ class Stm32f750UartWithDma : public CharacterDevice<char>
     unsigned rx_stream_id;
     unsigned tx_stream_id;
 
+    std::array<char, rx_ring_size> rx_ring;
+    bool receiving = false;
+    /* Position of the next byte to read in the ring buffer */
+    size_t rx_tail = 0;
+    /* Number of bytes received when the DMA last reported reaching half or
+     * the end of the ring buffer, at position rx_event_head, and number of
+     * bytes read. Both wrap around, only their difference matters. */
+    size_t nb_received   = 0;
+    size_t rx_event_head = 0;
+    size_t nb_consumed   = 0;
+    /* Set when unread bytes were overwritten, until a read reports it */
+    bool rx_overrun       = false;
+    ErrorCode read_status = ErrorCode::Success;
+    /* Position of the DMA in the ring buffer when the line last went idle,
+     * rx_ring_size if it has not yet */
+    size_t idle_head = rx_ring_size;
+
+    char* buf_in;
+    size_t nb_to_read = 0;
+    size_t nb_read    = 0;
+    std::optional<char> read_stop_char;
+
+    void startReception();
+    /** Position of the next byte the DMA will write in the ring buffer */
+    size_t rxHead();
+    /** Move the received bytes to the buffer of the running read, returns
+     * true if it is complete with read_status as its outcome. Must not be
+     * interrupted by the UART & DMA IRQs. */
+    bool readFromRing();
+
     void dmaTransferCompleted(unsigned stream_id,
                               size_t count,
                               ErrorStatus&& err);
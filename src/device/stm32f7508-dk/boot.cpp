@@ -525,10 +525,18 @@ static void m_initVtable(void)
     /* All interrupts default to error handler */
     for (unsigned i = 2; i < nb_irqs; ++i) { g_vtable[i] = handleError; }
 
-    g_vtable[TIM2_IRQn + vtable_offset]         = handleTIM2Event;
-    g_vtable[TIM5_IRQn + vtable_offset]         = handleTIM5Event;
-    g_vtable[USART1_IRQn + vtable_offset]       = handleUSART1Event;
-    g_vtable[DMA2_Stream7_IRQn + vtable_offset] = handleDMA2Stream7Event;
+    g_vtable[USART1_IRQn + vtable_offset]   = handleUSART1Event;
+    g_vtable[CAN2_TX_IRQn + vtable_offset]  = handleCAN2TXEvent;
+    g_vtable[CAN2_RX0_IRQn + vtable_offset] = handleCAN2RX0Event;
+    g_vtable[CAN2_RX1_IRQn + vtable_offset] = handleCAN2RX1Event;
+    g_vtable[CAN2_SCE_IRQn + vtable_offset] = handleCAN2SCEEvent;
+
+    for (const DmaStreamIrq& dma_irq : dma_stream_irqs) {
+        g_vtable[dma_irq.irq_nb + vtable_offset] = dma_irq.handler;
+    }
+    for (const TimerIrq& timer_irq : timer_irqs) {
+        g_vtable[timer_irq.irq_nb + vtable_offset] = timer_irq.handler;
+    }
 }
 
 static void m_setCoreSpeed(void)
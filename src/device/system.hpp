@@ -14,11 +14,14 @@
 
 #include "character_device.hpp"
 #include "dma_device.hpp"
+#include "input_capture_device.hpp"
+#include "pwm_device.hpp"
 #include "timer_device.hpp"
 
 #include <array>
 #include <event_loop.hpp>
 #include <hardware/mcu.hpp>
+#include <interrupt_executor.hpp>
 #include <memory>
 
 namespace hal
@@ -37,25 +40,57 @@ class System
 
     static System& getInstance();
     /** Conforming to MCU component naming, timer IDs start at 1 i.e. ID 2 is
-     * TIM2 */
-    TimerDevice& getTimer(unsigned id);
+     * TIM2
+     * @param tick_hz
+     *  Requested tick rate, the closest one the prescaler can reach is used,
+     * see @ref TimerDevice::getTickRate. A timer keeps the tick rate it was
+     * first requested with.
+     * @throw InvalidTimerTickRateException if the rate is null or differs from
+     * the one the timer was first requested with */
+    TimerDevice& getTimer(unsigned id,
+                          uint32_t tick_hz = default_timer_tick_hz);
+    /** The timer built by @ref getTimer, whatever its tick rate. Meant for
+     * interrupt handlers, it never constructs the timer.
+     * @throw InvalidTimerIdException if the ID is out of range or the timer
+     * has not been built yet */
+    TimerDevice& getTimerDevice(unsigned id);
     CharacterDevice<char>& getUart(unsigned id);
     /** NB: The underlying hardware between UARTs & UARTs with DMA is
      * the same so the caller should take care to use each UART device only
      * once. The System class may not perform any check on this. */
     CharacterDevice<char>& getUartWithDma(unsigned id);
     DmaDevice& getDma(unsigned id);
+    /** Capture edges on the first channel of the given timer, IDs are timer
+     * IDs and the tick rate is handled as by @ref getTimer.
+     * NB: The timer hardware is the same as the one of @ref getTimer so the
+     * caller should take care to use each timer only once. */
+    InputCaptureDevice&
+        getInputCapture(unsigned id, uint32_t tick_hz = default_timer_tick_hz);
+    /** Output a PWM signal on the first channel of the given timer, IDs are
+     * timer IDs and the tick rate is handled as by @ref getTimer.
+     * NB: The timer hardware is the same as the one of @ref getTimer so the
+     * caller should take care to use each timer only once. */
+    PwmDevice& getPwm(unsigned id, uint32_t tick_hz = default_timer_tick_hz);
 
     EventLoop& getEventLoop();
+    /** IDs start at 1. By default, executors with a higher ID preempt those
+     * with a lower ID and are all preempted by device interrupts. This may be
+     * changed through @ref InterruptExecutor::setNvicPriority. */
+    InterruptExecutor& getInterruptExecutor(unsigned id);
 
   private:
     System();
     ~System();
 
     std::array<std::unique_ptr<TimerDevice>, nb_timers> timers;
+    std::array<uint32_t, nb_timers> timer_tick_hz;
     std::array<std::unique_ptr<CharacterDevice<char>>, nb_uarts> uarts;
     std::array<std::unique_ptr<DmaDevice>, nb_dmas> dmas;
     std::array<std::unique_ptr<CharacterDevice<char>>, nb_uarts> uarts_with_dma;
+    std::array<std::unique_ptr<InputCaptureDevice>, nb_timers> input_captures;
+    std::array<std::unique_ptr<PwmDevice>, nb_timers> pwms;
+    std::array<std::unique_ptr<InterruptExecutor>, nb_interrupt_executors>
+        interrupt_executors;
 
     EventLoop event_loop;
 };
@@ -11,9 +11,10 @@
  ******************************************************************************/
 
 #include "error_status.hpp"
+#include "exceptions/device_exceptions.hpp"
 
-#include <chrono>
-#include <functional>
+#include <cstdint>
+#include <inplace_function.hpp>
 
 namespace hal
 {
@@ -26,32 +27,117 @@ namespace device
 class TimerDevice
 {
   public:
-    typedef std::chrono::duration<uint32_t, std::micro> WaitTimeUnitDuration;
+    /** Wait times are counted in device ticks, see @ref getTickRate */
+    typedef uint32_t TickCount;
+    typedef InplaceFunction<void(ErrorStatus&&)> WaitCompleteCallback;
+
+    /** A tick lasts divider / clk_hz seconds */
+    struct TickRate {
+        uint32_t clk_hz;
+        uint32_t divider;
+
+        /** Number of ticks in the given time, rounded up or down */
+        uint64_t fromNanoseconds(uint64_t ns, bool round_up) const
+        {
+            /* Seconds are handled apart so that products fit in 64 bits */
+            uint64_t rem_cycles = (ns % 1000000000) * clk_hz;
+            uint64_t cycles =
+                (ns / 1000000000) * clk_hz + rem_cycles / 1000000000;
+
+            if (!round_up) {
+                return cycles / divider;
+            }
+            cycles += (rem_cycles % 1000000000 != 0) ? 1 : 0;
+            return (cycles + divider - 1) / divider;
+        }
+
+        /** Time taken by the given number of ticks, rounded down */
+        uint64_t toNanoseconds(uint64_t ticks) const
+        {
+            uint64_t cycles = ticks * divider;
+
+            return (cycles / clk_hz) * 1000000000
+                   + (cycles % clk_hz) * 1000000000 / clk_hz;
+        }
+    };
 
     /** Set the callback function that will be called once the device completes
      * a wait operation.
      * @param callback
      *  The new callback function. It will receive as paramater an error status
      * indicating if the wait operation was succesfully executed or not. */
-    void setWaitCompleteCallback(std::function<void(ErrorStatus&&)>&& callback)
+    void setWaitCompleteCallback(WaitCompleteCallback&& callback)
     {
-        this->wait_complete_callback = callback;
+        this->wait_complete_callback = std::move(callback);
     }
 
-    virtual WaitTimeUnitDuration getRemainingWaitTime()     = 0;
-    virtual bool suspendWait()                              = 0;
-    virtual bool resumeWait()                               = 0;
-    virtual bool cancelWait()                               = 0;
-    virtual bool startWait(WaitTimeUnitDuration::rep count) = 0;
+    /* suspendWait() & resumeWait() bracket the critical sections of the
+     * driver: they only mask the device interrupt, the counter must keep on
+     * running meanwhile or every critical section would delay the running
+     * wait and the time it measures. A wait that goes off while suspended
+     * completes once resumed. */
+    virtual TickCount getRemainingWaitTime() = 0;
+    virtual bool suspendWait()               = 0;
+    virtual bool resumeWait()                = 0;
+    virtual bool cancelWait()                = 0;
+    virtual bool startWait(TickCount count)  = 0;
     /* An active wait that is sometimes handy when initializing peripherals and
      * such. No check is performed to see whether or not a Wait operation is
      * currently running so this should only be used during init, before
-     * entering the event loop. */
-    virtual void usleep(WaitTimeUnitDuration::rep count) = 0;
+     * entering the event loop. The wait time is given in µs whatever the tick
+     * rate. */
+    virtual void usleep(uint32_t us) = 0;
+
+    /** Largest count accepted by startWait(), longer waits must be split by
+     * the caller */
+    virtual TickCount getMaxWaitCount() const
+    {
+        return UINT32_MAX;
+    }
+    /** Duration of the ticks counted by the device, 1 µs by default */
+    virtual TickRate getTickRate() const
+    {
+        return TickRate{1000000, 1};
+    }
+
+    /** Start the counter in free-running mode: it then never stops nor
+     * restarts and wait operations are given as absolute deadlines through
+     * @ref setDeadline. Only suspendWait() & resumeWait() may still be used,
+     * they then mask the device interrupts without stopping the counter.
+     * Starting a counter that already runs free has no effect. Devices that
+     * do not support this mode raise @ref UnsupportedDeviceOperation. */
+    virtual void startFreeRunning()
+    {
+        throw UnsupportedDeviceOperation{"startFreeRunning"};
+    }
+    /** Number of ticks since the free-running counter was started, the
+     * hardware counter is extended to 64 bits in software. */
+    virtual uint64_t getCounter()
+    {
+        throw UnsupportedDeviceOperation{"getCounter"};
+    }
+    /** Number of deadlines that may be armed at the same time in free-running
+     * mode, one per compare channel of the device */
+    virtual size_t getNbDeadlineChannels() const
+    {
+        return 0;
+    }
+    /** The wait complete callback will be called once the free-running counter
+     * reaches the given value, right away if it is already past. This replaces
+     * any previous deadline of the channel. Channels are numbered from 0 and
+     * the callback does not tell which one went off. */
+    virtual void setDeadline(size_t channel, uint64_t deadline)
+    {
+        throw UnsupportedDeviceOperation{"setDeadline"};
+    }
+    virtual void clearDeadline(size_t channel)
+    {
+        throw UnsupportedDeviceOperation{"clearDeadline"};
+    }
 
   protected:
-    WaitTimeUnitDuration::rep programmed_count;
-    std::function<void(ErrorStatus&&)> wait_complete_callback;
+    TickCount programmed_count;
+    WaitCompleteCallback wait_complete_callback;
 };
 
 }  // namespace device
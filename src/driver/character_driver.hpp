@@ -1,7 +1,9 @@
 
 /*******************************************************************************
  * A generic character driver that can be used to read and write data to any
- * device that implements the CharacterDevice interface.
+ * device that implements the CharacterDevice interface. Writes submitted while
+ * the device is busy are queued and started back-to-back from the completion
+ * interrupt of the previous one.
  ******************************************************************************/
 
 #ifndef _HAL_DRIVER_CHARACTER_DRIVER_HPP
@@ -11,8 +13,26 @@
  * INCLUDE DIRECTIVES
  ******************************************************************************/
 
+#include <atomic>
+#include <coroutine.hpp>
 #include <device/character_device.hpp>
 #include <event_loop.hpp>
+#include <event_queue.hpp>
+
+#ifdef __cpp_impl_coroutine
+    #include <span>
+#endif
+
+
+/*******************************************************************************
+ * MACRO DEFINITION
+ ******************************************************************************/
+
+/* Maximum number of writes waiting for the running one to complete, must be a
+ * power of two */
+#ifndef CHARACTER_DRIVER_QUEUE_SIZE
+    #define CHARACTER_DRIVER_QUEUE_SIZE 4
+#endif
 
 namespace hal
 {
@@ -26,9 +46,47 @@ template<typename T>
 class CharacterDriver
 {
   public:
-    CharacterDriver(EventLoop& event_loop, device::CharacterDevice<T>& device);
+    typedef InplaceFunction<void(size_t, device::ErrorStatus&),
+                            callback_capacity>
+        Callback;
 
-    /** Start an asynchronous write operation on the character device
+    /** What to do when a write is submitted while the queue is full */
+    enum class OverflowPolicy {
+        /* Raise a @ref StartAsyncOpFailure */
+        Throw,
+        /* Discard the write, its callback receives the Aborted status, see
+         * @ref getNbDroppedWrites */
+        Drop,
+        /* Wait for the running write to complete. This must not be used from
+         * an interrupt context that masks the device interrupts. */
+        Block
+    };
+
+    static constexpr std::size_t write_queue_size =
+        CHARACTER_DRIVER_QUEUE_SIZE;
+
+    /** One of the buffers of a vectored write */
+    struct IoVec {
+        const T* buf;
+        size_t nb_elem;
+    };
+
+    /** @param executor
+     *  Runs the events published by this driver, either the EventLoop or an
+     * InterruptExecutor
+     * @param prio
+     *  Priority of these events within the executor
+     * @param overflow_policy
+     *  What to do when a write is submitted while the queue is full */
+    CharacterDriver(
+        Executor& executor,
+        device::CharacterDevice<T>& device,
+        Executor::Priority prio        = EventLoop::default_priority,
+        OverflowPolicy overflow_policy = OverflowPolicy::Throw);
+
+    /** Start an asynchronous write operation on the character device. If a
+     * write is running, this one is queued and started as soon as the
+     * previous ones are complete. The buffer must remain valid until then.
      * @param buf
      *  Pointer to the first character to write
      * @param nb_elem
@@ -37,19 +95,39 @@ class CharacterDriver
      *  The event which will be published to the queue once the write operation
      * is complete/canceled. The callback will receive the number of bytes
      * written and an error status as parameters.
-     * The given callback std::function may be empty, in which case no event
-     * will be published to the queue. */
-    void asyncWrite(
-        const T* buf,
-        size_t nb_elem,
-        std::function<void(size_t, device::ErrorStatus&)>&& event_callback =
-            std::function<void(size_t, device::ErrorStatus&)>{});
+     * The given callback may be empty, in which case no event will be
+     * published to the queue.
+     * @throw StartAsyncOpFailure if the queue is full and the overflow policy
+     * is Throw */
+    void asyncWrite(const T* buf,
+                    size_t nb_elem,
+                    Callback&& event_callback = Callback{});
+    /** Start an asynchronous write of several buffers one after the other,
+     * without copying them. Each buffer is handed to the device by the
+     * completion interrupt of the previous one. It is queued like
+     * @ref asyncWrite.
+     * @param iov
+     *  The buffers to write, this array must remain valid until the operation
+     * is complete. Empty buffers are skipped.
+     * @param nb_iov
+     *  The number of buffers
+     * @param event_callback
+     *  Same as for @ref asyncWrite, it is published once for the whole write
+     * and receives the total number of elements written. */
+    void asyncWritev(const IoVec* iov,
+                     size_t nb_iov,
+                     Callback&& event_callback = Callback{});
     /** Cancel the currently running write operation.
      * If no write op is running then @ref CancelAsyncOpFailure will be raised.
      * The callback given when calling @ref asyncWrite previously will be called
-     * with the Aborted status code. */
+     * with the Aborted status code. The queued writes are not cancelled, the
+     * next one starts right away. */
     void cancelAsyncWrite();
 
+    void setOverflowPolicy(OverflowPolicy policy);
+    /** Number of writes discarded because the queue was full */
+    std::size_t getNbDroppedWrites() const;
+
     /** Start an asynchronous read operation on the character device
      * @param buf
      *  A buffer where read characters will be copied
@@ -62,31 +140,147 @@ class CharacterDriver
      *  The event which will be published to the queue once the read operation
      * is complete/canceled. The callback will receive the number of bytes
      * read and an error status as parameters.
-     * The given callback std::function may be empty, in which case no event
-     * will be published to the queue. */
-    void asyncRead(
-        T* buf,
-        size_t nb_elem,
-        std::function<void(size_t, device::ErrorStatus&)>&& event_callback =
-            std::function<void(size_t, device::ErrorStatus&)>{},
-        std::optional<T> stop_char = std::nullopt);
+     * The given callback may be empty, in which case no event will be
+     * published to the queue. */
+    void asyncRead(T* buf,
+                   size_t nb_elem,
+                   Callback&& event_callback  = Callback{},
+                   std::optional<T> stop_char = std::nullopt);
     /** Cancel the currently running read operation.
      * If no read op is running then @ref CancelAsyncOpFailure will be raised.
      * The callback given when calling @ref asyncRead previously will be called
      * with the Aborted status code. */
     void cancelAsyncRead();
 
+#ifdef __cpp_impl_coroutine
+    /** Result of an awaited read or write operation */
+    struct IoResult {
+        size_t nb_elem;
+        device::ErrorStatus status;
+    };
+
+    /** Awaitable returned by @ref write. The awaiting coroutine is resumed by
+     * the executor of the driver once the operation is complete/canceled. */
+    class WriteAwaitable
+    {
+      public:
+        WriteAwaitable(CharacterDriver& driver, std::span<const T> buf);
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        /** Resumes the coroutine at once with a Failure status if the
+         * operation cannot be started, e.g. when the queue is full */
+        bool await_suspend(std::coroutine_handle<> handle);
+        IoResult await_resume() const noexcept;
+
+      private:
+        CharacterDriver& driver;
+        std::span<const T> buf;
+        IoResult result;
+    };
+
+    /** Awaitable returned by @ref writev. The awaiting coroutine is resumed by
+     * the executor of the driver once the operation is complete/canceled. */
+    class WritevAwaitable
+    {
+      public:
+        WritevAwaitable(CharacterDriver& driver, std::span<const IoVec> iov);
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        /** Resumes the coroutine at once with a Failure status if the
+         * operation cannot be started, e.g. when the queue is full */
+        bool await_suspend(std::coroutine_handle<> handle);
+        IoResult await_resume() const noexcept;
+
+      private:
+        CharacterDriver& driver;
+        std::span<const IoVec> iov;
+        IoResult result;
+    };
+
+    /** Awaitable returned by @ref read. The awaiting coroutine is resumed by
+     * the executor of the driver once the operation is complete/canceled. */
+    class ReadAwaitable
+    {
+      public:
+        ReadAwaitable(CharacterDriver& driver,
+                      std::span<T> buf,
+                      std::optional<T> stop_char);
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        /** Resumes the coroutine at once with a Failure status if the
+         * operation cannot be started, e.g. when a read is running */
+        bool await_suspend(std::coroutine_handle<> handle);
+        IoResult await_resume() const noexcept;
+
+      private:
+        CharacterDriver& driver;
+        std::span<T> buf;
+        std::optional<T> stop_char;
+        IoResult result;
+    };
+
+    /** Same as @ref asyncWrite but to be awaited from a coroutine:
+     * auto [nb_written, status] = co_await driver.write(buf); */
+    WriteAwaitable write(std::span<const T> buf);
+    /** Same as @ref asyncWritev but to be awaited from a coroutine:
+     * auto [nb_written, status] = co_await driver.writev(iov); */
+    WritevAwaitable writev(std::span<const IoVec> iov);
+    /** Same as @ref asyncRead but to be awaited from a coroutine:
+     * auto [nb_read, status] = co_await driver.read(buf); */
+    ReadAwaitable read(std::span<T> buf,
+                       std::optional<T> stop_char = std::nullopt);
+#endif
+
   private:
+    /* A regular write is stored in single, iov is then nullptr */
+    struct WriteRequest {
+        IoVec single;
+        const IoVec* iov;
+        size_t nb_iov;
+        Callback callback;
+    };
+
     bool busy_w = false;
-    std::function<void(size_t, device::ErrorStatus&)> write_callback;
+    Callback write_callback;
     bool busy_r = false;
-    std::function<void(size_t, device::ErrorStatus&)> read_callback;
+    Callback read_callback;
+
+    EventQueue<WriteRequest, write_queue_size> write_queue;
+    OverflowPolicy overflow_policy;
+    std::atomic<std::size_t> nb_dropped_writes{0};
+
+    /* Buffers of the running write, nb_iov is 0 once they are all written */
+    IoVec single_iov;
+    const IoVec* iov;
+    size_t nb_iov = 0;
+    size_t iov_idx;
+    size_t nb_written_iov;
 
+    /** Start writing the next non empty buffer of the running write, returns
+     * false if there is none left */
+    bool startNextIoVec();
+    /** Start the write right away or queue it if one is running */
+    void submitWrite(WriteRequest&& request);
+    void startWrite(WriteRequest&& request);
+    /** Start the next queued write, if any, from the completion of the
+     * previous one */
+    void startQueuedWrite();
+    void publishWrite(size_t nb_written, hal::device::ErrorStatus&& status);
     void completeWrite(size_t nb_written, hal::device::ErrorStatus&& status);
     void completeRead(size_t nb_read, hal::device::ErrorStatus&& status);
 
-    EventLoop& event_loop;
+    Executor& executor;
     device::CharacterDevice<T>& device;
+    const Executor::Priority prio;
 };
 
 }  // namespace driver
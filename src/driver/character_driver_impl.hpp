@@ -1,4 +1,3 @@
-
 /*******************************************************************************
  * INCLUDE DIRECTIVES
  ******************************************************************************/
@@ -7,6 +6,7 @@
 #include "driver_exceptions.hpp"
 
 #include <algorithm>
+#include <device/irqs.hpp>
 
 /*******************************************************************************
  * CONSTRUCTORS & DESTRUCTOR
@@ -14,16 +14,23 @@
 
 template<class T>
 hal::driver::CharacterDriver<T>::CharacterDriver(
-    EventLoop& event_loop,
-    device::CharacterDevice<T>& device)
-: event_loop{event_loop}, device{device}
+    Executor& executor,
+    device::CharacterDevice<T>& device,
+    Executor::Priority prio,
+    OverflowPolicy overflow_policy)
+: overflow_policy{overflow_policy}, executor{executor}, device{device},
+  prio{prio}
 {
     using namespace std;
 
-    device.setWriteCompleteCallback(bind(&CharacterDriver::completeWrite, this,
-                                         placeholders::_1, placeholders::_2));
-    device.setReadCompleteCallback(bind(&CharacterDriver::completeRead, this,
-                                        placeholders::_1, placeholders::_2));
+    device.setWriteCompleteCallback(
+        [this](size_t nb_written, device::ErrorStatus&& status) {
+            completeWrite(nb_written, move(status));
+        });
+    device.setReadCompleteCallback(
+        [this](size_t nb_read, device::ErrorStatus&& status) {
+            completeRead(nb_read, move(status));
+        });
 }
 
 /*******************************************************************************
@@ -34,6 +41,133 @@ hal::driver::CharacterDriver<T>::CharacterDriver(
  * PRIVATE METHOD IMPLEMENTATIONS
  ******************************************************************************/
 
+template<typename T>
+bool hal::driver::CharacterDriver<T>::startNextIoVec()
+{
+    while (iov_idx < nb_iov && iov[iov_idx].nb_elem == 0) {
+        ++iov_idx;
+    }
+    if (iov_idx == nb_iov) {
+        return false;
+    }
+
+    device.startWrite(iov[iov_idx].buf, iov[iov_idx].nb_elem);
+    return true;
+}
+
+template<typename T>
+void hal::driver::CharacterDriver<T>::submitWrite(WriteRequest&& request)
+{
+    using namespace std;
+    using namespace hal::device;
+
+    while (true) {
+        /* The completion interrupt pops the queued writes and clears the busy
+         * flag once there is none left */
+        disableInterrupts();
+        if (!busy_w) {
+            busy_w = true;
+            enableInterrupts();
+            try {
+                startWrite(move(request));
+            } catch (...) {
+                busy_w         = false;
+                write_callback = nullptr;
+                nb_iov         = 0;
+                throw;
+            }
+            return;
+        }
+        bool queued = write_queue.push(move(request));
+        enableInterrupts();
+
+        if (queued) {
+            return;
+        }
+
+        switch (overflow_policy) {
+            case OverflowPolicy::Block:
+                /* Retry once the running write is complete */
+                break;
+            case OverflowPolicy::Drop:
+                nb_dropped_writes.fetch_add(1, memory_order_relaxed);
+                if (request.callback) {
+                    executor.pushEvent(
+                        [callback = move(request.callback)]() mutable {
+                            ErrorStatus status{ErrorCode::Aborted};
+                            callback(0, status);
+                        },
+                        prio);
+                }
+                return;
+            default:
+                throw StartAsyncOpFailure{"Driver is busy"};
+        }
+    }
+}
+
+template<typename T>
+void hal::driver::CharacterDriver<T>::startWrite(WriteRequest&& request)
+{
+    using namespace hal::device;
+
+    /* A regular write is a vectored write of its single buffer */
+    write_callback = std::move(request.callback);
+    single_iov     = request.single;
+    iov            = (request.iov != nullptr) ? request.iov : &single_iov;
+    nb_iov         = request.nb_iov;
+    iov_idx        = 0;
+    nb_written_iov = 0;
+
+    /* The device may complete the operation before start returns */
+    if (!startNextIoVec()) {
+        nb_iov = 0;
+        completeWrite(0, ErrorCode::Success);
+    }
+}
+
+template<typename T>
+void hal::driver::CharacterDriver<T>::startQueuedWrite()
+{
+    using namespace hal::device;
+    WriteRequest request;
+
+    while (true) {
+        disableInterrupts();
+        bool popped = write_queue.pop(request);
+        if (!popped) {
+            busy_w = false;
+        }
+        enableInterrupts();
+
+        if (!popped) {
+            return;
+        }
+
+        try {
+            startWrite(std::move(request));
+            return;
+        } catch (...) {
+            /* Go on with the next one */
+            nb_iov = 0;
+            publishWrite(0, ErrorCode::Failure);
+        }
+    }
+}
+
+template<typename T>
+void hal::driver::CharacterDriver<T>::publishWrite(
+    size_t nb_written,
+    hal::device::ErrorStatus&& status)
+{
+    if (write_callback) {
+        executor.pushEvent(
+            [callback = std::move(write_callback), nb_written,
+             status]() mutable { callback(nb_written, status); },
+            prio);
+    }
+}
+
 /*******************************************************************************
  * PROTECTED METHOD IMPLEMENTATIONS
  ******************************************************************************/
@@ -47,18 +181,19 @@ template<typename T>
 void hal::driver::CharacterDriver<T>::asyncWrite(
     const T* buf,
     size_t nb_elem,
-    std::function<void(size_t, hal::device::ErrorStatus&)>&& event_callback)
+    Callback&& event_callback)
 {
-    using namespace std;
-    using namespace hal::device;
-
-    if (busy_w) {
-        throw StartAsyncOpFailure{"Driver is busy"};
-    }
+    submitWrite(
+        WriteRequest{{buf, nb_elem}, nullptr, 1, std::move(event_callback)});
+}
 
-    device.startWrite(buf, nb_elem);
-    busy_w         = true;
-    write_callback = event_callback;
+template<typename T>
+void hal::driver::CharacterDriver<T>::asyncWritev(const IoVec* iov,
+                                                  size_t nb_iov,
+                                                  Callback&& event_callback)
+{
+    submitWrite(
+        WriteRequest{{nullptr, 0}, iov, nb_iov, std::move(event_callback)});
 }
 
 template<typename T>
@@ -66,11 +201,30 @@ void hal::driver::CharacterDriver<T>::completeWrite(
     size_t nb_written,
     hal::device::ErrorStatus&& status)
 {
-    if (write_callback) {
-        event_loop.pushEvent(bind(write_callback, nb_written, status));
+    using namespace hal::device;
+
+    /* Chain the next buffer of a vectored write straight from the completion
+     * interrupt of the previous one */
+    if (iov_idx < nb_iov) {
+        nb_written_iov += nb_written;
+        ++iov_idx;
+        if (!status) {
+            try {
+                if (startNextIoVec()) {
+                    return;
+                }
+            } catch (...) {
+                status = ErrorCode::Failure;
+            }
+        }
+
+        nb_written = nb_written_iov;
+        nb_iov     = 0;
     }
 
-    busy_w = false;
+    publishWrite(nb_written, std::move(status));
+    /* Likewise for the next queued write */
+    startQueuedWrite();
 }
 
 template<typename T>
@@ -89,11 +243,24 @@ void hal::driver::CharacterDriver<T>::cancelAsyncWrite()
 
     completeWrite(nb_written, ErrorCode::Aborted);
 }
+
+template<typename T>
+void hal::driver::CharacterDriver<T>::setOverflowPolicy(OverflowPolicy policy)
+{
+    overflow_policy = policy;
+}
+
+template<typename T>
+size_t hal::driver::CharacterDriver<T>::getNbDroppedWrites() const
+{
+    return nb_dropped_writes.load(std::memory_order_relaxed);
+}
+
 template<typename T>
 void hal::driver::CharacterDriver<T>::asyncRead(
     T* buf,
     size_t nb_elem,
-    std::function<void(size_t, hal::device::ErrorStatus&)>&& event_callback,
+    Callback&& event_callback,
     std::optional<T> stop_char)
 {
     using namespace std;
@@ -103,9 +270,16 @@ void hal::driver::CharacterDriver<T>::asyncRead(
         throw StartAsyncOpFailure{"Driver is busy"};
     }
 
-    device.startRead(buf, nb_elem, stop_char);
+    /* The device may complete the operation before start returns */
     busy_r        = true;
-    read_callback = event_callback;
+    read_callback = move(event_callback);
+    try {
+        device.startRead(buf, nb_elem, stop_char);
+    } catch (...) {
+        busy_r        = false;
+        read_callback = nullptr;
+        throw;
+    }
 }
 
 template<typename T>
@@ -114,7 +288,11 @@ void hal::driver::CharacterDriver<T>::completeRead(
     hal::device::ErrorStatus&& status)
 {
     if (read_callback) {
-        event_loop.pushEvent(bind(read_callback, nb_read, status));
+        executor.pushEvent(
+            [callback = std::move(read_callback), nb_read, status]() mutable {
+                callback(nb_read, status);
+            },
+            prio);
     }
 
     busy_r = false;
@@ -136,3 +314,137 @@ void hal::driver::CharacterDriver<T>::cancelAsyncRead()
 
     completeRead(nb_read, ErrorCode::Aborted);
 }
+
+#ifdef __cpp_impl_coroutine
+template<typename T>
+typename hal::driver::CharacterDriver<T>::WriteAwaitable
+    hal::driver::CharacterDriver<T>::write(std::span<const T> buf)
+{
+    return WriteAwaitable{*this, buf};
+}
+
+template<typename T>
+typename hal::driver::CharacterDriver<T>::WritevAwaitable
+    hal::driver::CharacterDriver<T>::writev(std::span<const IoVec> iov)
+{
+    return WritevAwaitable{*this, iov};
+}
+
+template<typename T>
+typename hal::driver::CharacterDriver<T>::ReadAwaitable
+    hal::driver::CharacterDriver<T>::read(std::span<T> buf,
+                                          std::optional<T> stop_char)
+{
+    return ReadAwaitable{*this, buf, stop_char};
+}
+
+template<typename T>
+hal::driver::CharacterDriver<T>::WriteAwaitable::WriteAwaitable(
+    CharacterDriver& driver,
+    std::span<const T> buf)
+: driver{driver}, buf{buf}, result{0, device::ErrorCode::Success}
+{
+}
+
+template<typename T>
+bool hal::driver::CharacterDriver<T>::WriteAwaitable::await_suspend(
+    std::coroutine_handle<> handle)
+{
+    try {
+        driver.asyncWrite(
+            buf.data(), buf.size(),
+            [this, handle](size_t nb_written, device::ErrorStatus& status) {
+                result = IoResult{nb_written, status};
+                handle.resume();
+            });
+    } catch (...) {
+        result = IoResult{0, device::ErrorCode::Failure};
+        return false;
+    }
+
+    return true;
+}
+
+template<typename T>
+typename hal::driver::CharacterDriver<T>::IoResult
+    hal::driver::CharacterDriver<T>::WriteAwaitable::await_resume()
+        const noexcept
+{
+    return result;
+}
+
+template<typename T>
+hal::driver::CharacterDriver<T>::WritevAwaitable::WritevAwaitable(
+    CharacterDriver& driver,
+    std::span<const IoVec> iov)
+: driver{driver}, iov{iov}, result{0, device::ErrorCode::Success}
+{
+}
+
+template<typename T>
+bool hal::driver::CharacterDriver<T>::WritevAwaitable::await_suspend(
+    std::coroutine_handle<> handle)
+{
+    try {
+        driver.asyncWritev(
+            iov.data(), iov.size(),
+            [this, handle](size_t nb_written, device::ErrorStatus& status) {
+                result = IoResult{nb_written, status};
+                handle.resume();
+            });
+    } catch (...) {
+        result = IoResult{0, device::ErrorCode::Failure};
+        return false;
+    }
+
+    return true;
+}
+
+template<typename T>
+typename hal::driver::CharacterDriver<T>::IoResult
+    hal::driver::CharacterDriver<T>::WritevAwaitable::await_resume()
+        const noexcept
+{
+    return result;
+}
+
+template<typename T>
+hal::driver::CharacterDriver<T>::ReadAwaitable::ReadAwaitable(
+    CharacterDriver& driver,
+    std::span<T> buf,
+    std::optional<T> stop_char)
+: driver{driver},
+  buf{buf},
+  stop_char{stop_char},
+  result{0, device::ErrorCode::Success}
+{
+}
+
+template<typename T>
+bool hal::driver::CharacterDriver<T>::ReadAwaitable::await_suspend(
+    std::coroutine_handle<> handle)
+{
+    try {
+        driver.asyncRead(
+            buf.data(), buf.size(),
+            [this, handle](size_t nb_read, device::ErrorStatus& status) {
+                result = IoResult{nb_read, status};
+                handle.resume();
+            },
+            stop_char);
+    } catch (...) {
+        result = IoResult{0, device::ErrorCode::Failure};
+        return false;
+    }
+
+    return true;
+}
+
+template<typename T>
+typename hal::driver::CharacterDriver<T>::IoResult
+    hal::driver::CharacterDriver<T>::ReadAwaitable::await_resume()
+        const noexcept
+{
+    return result;
+}
+#endif
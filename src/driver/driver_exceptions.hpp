@@ -55,6 +55,13 @@ struct CancelAsyncOpFailure : std::exception {
     }
 };
 
+struct EmptyTimerDriverPoolException : std::exception {
+    const char* what() const noexcept override
+    {
+        return "A timer driver pool needs at least one timer device";
+    }
+};
+
 
 }  // namespace device
 }  // namespace hal
@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * Implementation file of the ring buffer half tracker
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "half_ring_tracker.hpp"
+
+using namespace std;
+using namespace hal::driver;
+using namespace hal::device;
+
+
+/*******************************************************************************
+ * PUBLIC METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+void HalfRingTracker::start()
+{
+    halves.store(0);
+    ++run;
+}
+
+void HalfRingTracker::stop()
+{
+    ++run;
+}
+
+bool HalfRingTracker::onHalfDone(size_t half)
+{
+    size_t other  = 1 - half;
+    uint32_t prev = halves.fetch_or(pendingBit(half));
+
+    /* The device goes on with the other half, which is missed if its event
+     * has yet to run */
+    if (prev & pendingBit(other)) {
+        halves.fetch_or(missedBit(other));
+        nb_missed.fetch_add(1, memory_order_relaxed);
+    }
+
+    /* The event pushed the previous time this half was done has not run
+     * yet */
+    if (prev & pendingBit(half)) {
+        halves.fetch_or(missedBit(half));
+        nb_missed.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    return true;
+}
+
+ErrorStatus HalfRingTracker::getStatus(size_t half) const
+{
+    return (halves.load() & missedBit(half)) ? ErrorCode::Failure
+                                             : ErrorCode::Success;
+}
+
+void HalfRingTracker::release(size_t half)
+{
+    halves.fetch_and(~(pendingBit(half) | missedBit(half)));
+}
+
+uint32_t HalfRingTracker::getNbMissed() const
+{
+    return nb_missed.load(memory_order_relaxed);
+}
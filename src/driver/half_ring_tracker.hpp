@@ -0,0 +1,83 @@
+/*******************************************************************************
+ * Bookkeeping shared by the drivers that hand over a ring buffer one half at a
+ * time, while the device goes on with the other half. It tells which halves
+ * await their event and which ones were missed because the device went on
+ * with them before their event could run, e.g. captures that were overwritten
+ * or duty cycles that were output again.
+ ******************************************************************************/
+
+#ifndef _HAL_DRIVER_HALF_RING_TRACKER_HPP
+#define _HAL_DRIVER_HALF_RING_TRACKER_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <device/error_status.hpp>
+
+namespace hal
+{
+namespace driver
+{
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+class HalfRingTracker
+{
+  public:
+    /** Forget the halves of the previous run, before the device starts */
+    void start();
+    /** Drop the events of the current run that are still queued */
+    void stop();
+
+    /** Identifies the current run, events capture it when they are pushed */
+    unsigned getRun() const
+    {
+        return run;
+    }
+    /** Whether an event pushed during the given run must still be handled */
+    bool isCurrent(unsigned run) const
+    {
+        return run == this->run;
+    }
+
+    /** To be called from the device callback each time it is done with a
+     * half. Returns true if an event must be pushed for it, false if the one
+     * pushed the previous time is still queued: it will handle this half. */
+    bool onHalfDone(size_t half);
+    /** Failure if the half was missed since it was last handed over */
+    device::ErrorStatus getStatus(size_t half) const;
+    /** To be called once the event of the half ran, unless the run changed in
+     * the meantime */
+    void release(size_t half);
+
+    /** Number of halves missed since the tracker was built */
+    uint32_t getNbMissed() const;
+
+  private:
+    /* Bit h is set while half h awaits its event, bit h + 2 when it has been
+     * missed in the meantime */
+    static constexpr uint32_t pendingBit(size_t half)
+    {
+        return 1UL << half;
+    }
+    static constexpr uint32_t missedBit(size_t half)
+    {
+        return 1UL << (half + 2);
+    }
+
+    /* Incremented at each start & stop so that the events of a previous run
+     * are dropped */
+    unsigned run = 0;
+    std::atomic<uint32_t> halves{0};
+    std::atomic<uint32_t> nb_missed{0};
+};
+
+}  // namespace driver
+}  // namespace hal
+
+#endif
@@ -0,0 +1,213 @@
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "input_capture_driver.hpp"
+
+#include "driver_exceptions.hpp"
+
+
+using namespace std;
+using namespace hal::driver;
+using namespace hal::device;
+
+
+/*******************************************************************************
+ * CONSTRUCTORS & DESTRUCTOR
+ ******************************************************************************/
+
+InputCaptureDriver::Captures::Iterator::Iterator(const Captures& captures,
+                                                 const uint32_t* raw)
+: captures{captures}, raw{raw}, prev_ticks{captures.base_ticks},
+  prev_count{captures.base_count}
+{
+}
+
+InputCaptureDriver::InputCaptureDriver(Executor& executor,
+                                       device::InputCaptureDevice& device,
+                                       Executor::Priority prio)
+: executor{executor}, device{device}, prio{prio}
+{
+    device.setCaptureCallback(
+        [this](size_t nb_captures, ErrorStatus&& status) {
+            onHalfFilled(nb_captures, move(status));
+        });
+}
+
+InputCaptureDriver::~InputCaptureDriver()
+{
+    if (running) {
+        device.stopCapture();
+    }
+}
+
+/*******************************************************************************
+ * OPERATOR IMPLEMENTATIONS
+ ******************************************************************************/
+
+InputCaptureDriver::Timestamp
+    InputCaptureDriver::Captures::Iterator::operator*() const
+{
+    uint64_t ticks = prev_ticks + ((*raw - prev_count) & captures.max_count);
+
+    return Timestamp{captures.tick_rate.toNanoseconds(ticks)};
+}
+
+InputCaptureDriver::Captures::Iterator&
+    InputCaptureDriver::Captures::Iterator::operator++()
+{
+    prev_ticks += (*raw - prev_count) & captures.max_count;
+    prev_count = *raw;
+    ++raw;
+
+    return *this;
+}
+
+/*******************************************************************************
+ * PRIVATE METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+void InputCaptureDriver::onHalfFilled(size_t nb_captures, ErrorStatus&& status)
+{
+    if (!running) {
+        return;
+    }
+
+    unsigned run = halves.getRun();
+    if (status) {
+        executor.pushEvent(
+            [this, run, status]() { runFailure(run, status); }, prio);
+        return;
+    }
+
+    /* The device goes on filling the other half. If the event pushed the
+     * previous time this half was filled has not run yet, it will report the
+     * newest captures. */
+    size_t half = (nb_captures == half_size) ? 0 : 1;
+    if (halves.onHalfDone(half)) {
+        executor.pushEvent([this, run, half]() { runCallback(run, half); },
+                           prio);
+    }
+}
+
+void InputCaptureDriver::runCallback(unsigned run, size_t half)
+{
+    /* The capture was stopped since the event was pushed */
+    if (!halves.isCurrent(run)) {
+        return;
+    }
+
+    Captures captures;
+    captures.raw         = ring + half * half_size;
+    captures.nb_captures = half_size;
+    captures.base_ticks  = last_ticks;
+    captures.base_count  = last_count;
+    captures.max_count   = max_count;
+    captures.tick_rate   = tick_rate;
+
+    /* Unwrapped before the callback runs, the device may overwrite the batch
+     * while it does */
+    uint64_t batch_last_ticks = last_ticks;
+    uint32_t batch_last_count = last_count;
+    for (size_t i = 0; i < half_size; ++i) {
+        batch_last_ticks += (captures.raw[i] - batch_last_count) & max_count;
+        batch_last_count = captures.raw[i];
+    }
+
+    ErrorStatus status = halves.getStatus(half);
+    if (callback) {
+        callback(captures, status);
+    }
+
+    /* The callback may have restarted the capture */
+    if (halves.isCurrent(run)) {
+        halves.release(half);
+        last_ticks = batch_last_ticks;
+        last_count = batch_last_count;
+    }
+}
+
+void InputCaptureDriver::runFailure(unsigned run, ErrorStatus status)
+{
+    if (!halves.isCurrent(run)) {
+        return;
+    }
+
+    Captures captures;
+    captures.raw         = ring;
+    captures.nb_captures = 0;
+    captures.base_ticks  = last_ticks;
+    captures.base_count  = last_count;
+    captures.max_count   = max_count;
+    captures.tick_rate   = tick_rate;
+
+    /* The device stopped on its own */
+    running = false;
+    halves.stop();
+    if (callback) {
+        callback(captures, status);
+    }
+}
+
+/*******************************************************************************
+ * PROTECTED METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PUBLIC METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+void InputCaptureDriver::start(uint32_t* ring,
+                               size_t ring_size,
+                               Edge edge,
+                               Callback&& callback)
+{
+    if (running) {
+        throw StartAsyncOpFailure{"Driver is busy"};
+    }
+    if (ring_size == 0 || ring_size % 2 != 0) {
+        throw StartAsyncOpFailure{"Ring size must be even"};
+    }
+
+    this->ring     = ring;
+    half_size      = ring_size / 2;
+    max_count      = device.getMaxCount();
+    tick_rate      = device.getTickRate();
+    last_ticks     = 0;
+    last_count     = 0;
+    this->callback = move(callback);
+    halves.start();
+
+    /* The device may report captures before start returns */
+    running = true;
+    try {
+        device.startCapture(ring, ring_size, edge);
+    } catch (...) {
+        running        = false;
+        this->callback = nullptr;
+        throw;
+    }
+}
+
+void InputCaptureDriver::stop()
+{
+    if (!running) {
+        throw CancelAsyncOpFailure{"Nothing to cancel"};
+    }
+
+    device.stopCapture();
+    running = false;
+    /* Drop the batches whose events are still queued */
+    halves.stop();
+}
+
+bool InputCaptureDriver::isRunning() const
+{
+    return running;
+}
+
+uint32_t InputCaptureDriver::getNbOverruns() const
+{
+    return halves.getNbMissed();
+}
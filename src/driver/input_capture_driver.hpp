@@ -0,0 +1,160 @@
+/*******************************************************************************
+ * A generic input capture driver that timestamps the edges of an input signal
+ * using any device that implements the InputCaptureDevice interface. Captures
+ * are handed over in batches, one per half of the ring buffer filled by the
+ * device, so that the executor is not woken up on every edge.
+ ******************************************************************************/
+
+#ifndef _HAL_DRIVER_INPUT_CAPTURE_DRIVER_HPP
+#define _HAL_DRIVER_INPUT_CAPTURE_DRIVER_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "half_ring_tracker.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <device/input_capture_device.hpp>
+#include <event_loop.hpp>
+
+namespace hal
+{
+namespace driver
+{
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+class InputCaptureDriver
+{
+  public:
+    /** Time elapsed between the start of the capture and an edge */
+    typedef std::chrono::duration<uint64_t, std::nano> Timestamp;
+    typedef device::InputCaptureDevice::Edge Edge;
+
+    /** Captures of half of the ring buffer, to be iterated over in order:
+     * for (Timestamp timestamp : captures) {}
+     * Timestamps are computed on the fly, straight from the ring buffer which
+     * the device overwrites half a ring later: they must not be accessed once
+     * the callback returned. */
+    class Captures
+    {
+      public:
+        class Iterator
+        {
+          public:
+            Timestamp operator*() const;
+            Iterator& operator++();
+            bool operator!=(const Iterator& other) const
+            {
+                return raw != other.raw;
+            }
+
+          private:
+            friend class Captures;
+
+            Iterator(const Captures& captures, const uint32_t* raw);
+
+            const Captures& captures;
+            const uint32_t* raw;
+            /* Unwrapped counter value of the previous capture */
+            uint64_t prev_ticks;
+            uint32_t prev_count;
+        };
+
+        size_t size() const
+        {
+            return nb_captures;
+        }
+
+        Iterator begin() const
+        {
+            return Iterator{*this, raw};
+        }
+        Iterator end() const
+        {
+            return Iterator{*this, raw + nb_captures};
+        }
+
+      private:
+        friend class InputCaptureDriver;
+
+        const uint32_t* raw;
+        size_t nb_captures;
+        /* Last capture of the previous batch */
+        uint64_t base_ticks;
+        uint32_t base_count;
+        uint32_t max_count;
+        device::TimerDevice::TickRate tick_rate;
+    };
+
+    typedef InplaceFunction<void(const Captures&, device::ErrorStatus&),
+                            callback_capacity>
+        Callback;
+
+    /** @param executor
+     *  Runs the events published by this driver, either the EventLoop or an
+     * InterruptExecutor
+     * @param prio
+     *  Priority of these events within the executor */
+    InputCaptureDriver(Executor& executor,
+                       device::InputCaptureDevice& device,
+                       Executor::Priority prio = EventLoop::default_priority);
+    ~InputCaptureDriver();
+
+    /** Start timestamping edges of the input. The counter of the device is
+     * extended to 64 bits in software, which requires that consecutive edges
+     * are less than a full counter period apart.
+     * @param ring
+     *  Buffer where the device writes raw counter values, it must outlive the
+     * capture
+     * @param ring_size
+     *  The number of captures the ring buffer holds, it must be even
+     * @param callback
+     *  Called for each half of the ring buffer once it is filled. The status is
+     * Failure if the device overwrote the batch before the callback could run,
+     * its timestamps may then be wrong. It is called a last time with an empty
+     * batch if the device fails, capturing then stops.
+     * @throw StartAsyncOpFailure if a capture is already running or the ring
+     * size is not even */
+    void start(uint32_t* ring,
+               size_t ring_size,
+               Edge edge,
+               Callback&& callback);
+    /** Stop capturing, the callback is not called anymore once this returns.
+     * @throw CancelAsyncOpFailure if no capture is running */
+    void stop();
+
+    bool isRunning() const;
+    /** Number of batches overwritten by the device before their callback
+     * could run */
+    uint32_t getNbOverruns() const;
+
+  private:
+    void onHalfFilled(size_t nb_captures, device::ErrorStatus&& status);
+    void runCallback(unsigned run, size_t half);
+    void runFailure(unsigned run, device::ErrorStatus status);
+
+    Executor& executor;
+    device::InputCaptureDevice& device;
+    const Executor::Priority prio;
+
+    bool running = false;
+    /* Missed halves are the batches overwritten before their callback ran */
+    HalfRingTracker halves;
+    Callback callback;
+    uint32_t* ring;
+    size_t half_size;
+    uint32_t max_count;
+    device::TimerDevice::TickRate tick_rate;
+    uint64_t last_ticks;
+    uint32_t last_count;
+};
+
+}  // namespace driver
+}  // namespace hal
+
+#endif
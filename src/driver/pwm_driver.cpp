@@ -0,0 +1,239 @@
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "pwm_driver.hpp"
+
+#include "driver_exceptions.hpp"
+
+#include <algorithm>
+
+
+using namespace std;
+using namespace hal::driver;
+using namespace hal::device;
+
+
+/*******************************************************************************
+ * CONSTRUCTORS & DESTRUCTOR
+ ******************************************************************************/
+
+PwmDriver::PwmDriver(Executor& executor,
+                     device::PwmDevice& device,
+                     Executor::Priority prio)
+: executor{executor}, device{device}, prio{prio}
+{
+    device.setWaveformCallback(
+        [this](size_t nb_duty_cycles, ErrorStatus&& status) {
+            onWaveformEvent(nb_duty_cycles, move(status));
+        });
+}
+
+PwmDriver::~PwmDriver()
+{
+    if (busy) {
+        device.stopWaveform();
+    }
+}
+
+/*******************************************************************************
+ * OPERATOR IMPLEMENTATIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PRIVATE METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+void PwmDriver::onWaveformEvent(size_t nb_duty_cycles, ErrorStatus&& status)
+{
+    if (!busy) {
+        return;
+    }
+
+    if (!streaming) {
+        completeWrite(move(status));
+        return;
+    }
+
+    unsigned run = halves.getRun();
+    if (status) {
+        executor.pushEvent(
+            [this, run, status]() { runFailure(run, status); }, prio);
+        return;
+    }
+
+    /* The device goes on with the other half, which is output again if it
+     * has yet to be refilled. The refill requested the previous time this
+     * half was consumed may not have run yet. */
+    size_t half = (nb_duty_cycles == half_size) ? 0 : 1;
+    if (halves.onHalfDone(half)) {
+        executor.pushEvent([this, run, half]() { runRefill(run, half); },
+                           prio);
+    }
+}
+
+void PwmDriver::completeWrite(ErrorStatus&& status)
+{
+    if (write_callback) {
+        executor.pushEvent(
+            [callback = move(write_callback), status]() mutable {
+                callback(status);
+            },
+            prio);
+    }
+
+    busy = false;
+}
+
+void PwmDriver::runRefill(unsigned run, size_t half)
+{
+    /* The stream was stopped since the event was pushed */
+    if (!halves.isCurrent(run)) {
+        return;
+    }
+
+    ErrorStatus status = halves.getStatus(half);
+    if (refill_callback) {
+        refill_callback(ring + half * half_size, half_size, status);
+    }
+
+    /* The callback may have restarted the stream */
+    if (halves.isCurrent(run)) {
+        halves.release(half);
+    }
+}
+
+void PwmDriver::runFailure(unsigned run, ErrorStatus status)
+{
+    if (!halves.isCurrent(run)) {
+        return;
+    }
+
+    /* The device stopped on its own */
+    busy      = false;
+    streaming = false;
+    halves.stop();
+    if (refill_callback) {
+        refill_callback(ring, 0, status);
+    }
+}
+
+/*******************************************************************************
+ * PROTECTED METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PUBLIC METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+uint32_t PwmDriver::toTicks(Duration time) const
+{
+    TimerDevice::TickRate tick_rate = device.getTickRate();
+    uint64_t ns                     = time.count();
+    uint64_t below                  = tick_rate.fromNanoseconds(ns, false);
+    uint64_t above                  = tick_rate.fromNanoseconds(ns, true);
+
+    /* Pick whichever is closest */
+    uint64_t ticks = (ns - tick_rate.toNanoseconds(below)
+                      <= tick_rate.toNanoseconds(above) - ns)
+                         ? below
+                         : above;
+
+    return static_cast<uint32_t>(min<uint64_t>(ticks, UINT32_MAX));
+}
+
+void PwmDriver::setPeriod(Duration period)
+{
+    device.setPeriod(toTicks(period));
+}
+
+uint32_t PwmDriver::getPeriod() const
+{
+    return device.getPeriod();
+}
+
+void PwmDriver::setDutyCycle(uint32_t duty_cycle)
+{
+    if (busy) {
+        throw StartAsyncOpFailure{"Driver is busy"};
+    }
+
+    device.setDutyCycle(duty_cycle);
+}
+
+void PwmDriver::asyncWrite(const uint32_t* duty_cycles,
+                           size_t nb_duty_cycles,
+                           Callback&& callback)
+{
+    if (busy) {
+        throw StartAsyncOpFailure{"Driver is busy"};
+    }
+
+    /* The device may complete the operation before start returns */
+    busy           = true;
+    streaming      = false;
+    write_callback = move(callback);
+    try {
+        device.startWaveform(duty_cycles, nb_duty_cycles, false);
+    } catch (...) {
+        busy           = false;
+        write_callback = nullptr;
+        throw;
+    }
+}
+
+void PwmDriver::startStream(uint32_t* ring,
+                            size_t ring_size,
+                            RefillCallback&& callback)
+{
+    if (busy) {
+        throw StartAsyncOpFailure{"Driver is busy"};
+    }
+    if (ring_size == 0 || ring_size % 2 != 0) {
+        throw StartAsyncOpFailure{"Ring size must be even"};
+    }
+
+    this->ring      = ring;
+    half_size       = ring_size / 2;
+    refill_callback = move(callback);
+    halves.start();
+
+    busy      = true;
+    streaming = true;
+    try {
+        device.startWaveform(ring, ring_size, true);
+    } catch (...) {
+        busy            = false;
+        streaming       = false;
+        refill_callback = nullptr;
+        throw;
+    }
+}
+
+void PwmDriver::stop()
+{
+    if (!busy) {
+        throw CancelAsyncOpFailure{"Nothing to cancel"};
+    }
+
+    device.stopWaveform();
+    if (streaming) {
+        busy      = false;
+        streaming = false;
+        /* Drop the refills whose events are still queued */
+        halves.stop();
+    } else {
+        completeWrite(ErrorCode::Aborted);
+    }
+}
+
+bool PwmDriver::isBusy() const
+{
+    return busy;
+}
+
+uint32_t PwmDriver::getNbUnderruns() const
+{
+    return halves.getNbMissed();
+}
@@ -0,0 +1,124 @@
+/*******************************************************************************
+ * A generic PWM driver that outputs waveforms, one duty cycle per period, using
+ * any device that implements the PwmDevice interface. Waveforms are either
+ * written once from a buffer or streamed continuously from a ring buffer whose
+ * halves are refilled while the other one is being output.
+ ******************************************************************************/
+
+#ifndef _HAL_DRIVER_PWM_DRIVER_HPP
+#define _HAL_DRIVER_PWM_DRIVER_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "half_ring_tracker.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <device/pwm_device.hpp>
+#include <event_loop.hpp>
+
+namespace hal
+{
+namespace driver
+{
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+class PwmDriver
+{
+  public:
+    typedef InplaceFunction<void(device::ErrorStatus&), callback_capacity>
+        Callback;
+    typedef InplaceFunction<void(uint32_t*, size_t, device::ErrorStatus&),
+                            callback_capacity>
+        RefillCallback;
+
+    typedef std::chrono::duration<uint64_t, std::nano> Duration;
+
+    /** @param executor
+     *  Runs the events published by this driver, either the EventLoop or an
+     * InterruptExecutor
+     * @param prio
+     *  Priority of these events within the executor. Refills are time
+     * critical so they default to the highest one. */
+    PwmDriver(Executor& executor,
+              device::PwmDevice& device,
+              Executor::Priority prio = EventLoop::highest_priority);
+    ~PwmDriver();
+
+    /** Number of device ticks closest to the given time, duty cycles are
+     * given in ticks */
+    uint32_t toTicks(Duration time) const;
+    /** Set the period to the closest number of ticks, it is used from the
+     * next period on
+     * @throw InvalidTimerCountException if it is out of the device range */
+    void setPeriod(Duration period);
+    /** Period in ticks, duty cycles range from 0 to this value */
+    uint32_t getPeriod() const;
+    /** Output a constant duty cycle, in ticks
+     * @throw StartAsyncOpFailure if a waveform is being output */
+    void setDutyCycle(uint32_t duty_cycle);
+
+    /** Output one duty cycle of the buffer per period, starting with the next
+     * period. The output then keeps the last duty cycle of the buffer which
+     * usually should be 0.
+     * @param callback
+     *  Called once the buffer may be reused, while its last duty cycle is
+     * output. It receives the Aborted status if @ref stop is called first.
+     * @throw StartAsyncOpFailure if a waveform is being output */
+    void asyncWrite(const uint32_t* duty_cycles,
+                    size_t nb_duty_cycles,
+                    Callback&& callback = Callback{});
+    /** Output the ring buffer over and over until @ref stop is called. It must
+     * be filled beforehand.
+     * @param ring_size
+     *  The number of duty cycles the ring buffer holds, it must be even
+     * @param callback
+     *  Called each time half of the ring buffer has been consumed with the
+     * half to refill and its size, while the other half is output. The status
+     * is Failure if the half was not refilled in time, its duty cycles have
+     * then been output again. It is called a last time with an empty half if
+     * the device fails, the waveform then stops.
+     * @throw StartAsyncOpFailure if a waveform is being output or the ring
+     * size is not even */
+    void startStream(uint32_t* ring,
+                     size_t ring_size,
+                     RefillCallback&& callback);
+    /** Stop the waveform and keep the output low. The callback of a streamed
+     * waveform is not called anymore once this returns.
+     * @throw CancelAsyncOpFailure if no waveform is being output */
+    void stop();
+
+    bool isBusy() const;
+    /** Number of ring buffer halves output again because they were not
+     * refilled in time */
+    uint32_t getNbUnderruns() const;
+
+  private:
+    void onWaveformEvent(size_t nb_duty_cycles, device::ErrorStatus&& status);
+    void completeWrite(device::ErrorStatus&& status);
+    void runRefill(unsigned run, size_t half);
+    void runFailure(unsigned run, device::ErrorStatus status);
+
+    Executor& executor;
+    device::PwmDevice& device;
+    const Executor::Priority prio;
+
+    bool busy      = false;
+    bool streaming = false;
+    /* Missed halves are the ones output again before their refill ran */
+    HalfRingTracker halves;
+    Callback write_callback;
+    RefillCallback refill_callback;
+    uint32_t* ring;
+    size_t half_size;
+};
+
+}  // namespace driver
+}  // namespace hal
+
+#endif
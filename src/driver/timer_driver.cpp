@@ -7,12 +7,10 @@
 
 #include "driver_exceptions.hpp"
 
-#include <algorithm>
 #include <device/irqs.hpp>
 
 
 using namespace std;
-using namespace std::placeholders;
 using namespace hal::driver;
 using namespace hal::device;
 
@@ -26,10 +24,54 @@ TimerDriver::Timer::Timer(TimerDriver& owner, Handle handle)
 {
 }
 
-TimerDriver::TimerDriver(EventLoop& event_loop, device::TimerDevice& device)
-: event_loop{event_loop}, device{device}
+TimerDriver::IntrusiveTimer::IntrusiveTimer(TimerDriver& driver)
+: driver{driver}
 {
-    device.setWaitCompleteCallback(bind(&TimerDriver::completeWait, this, _1));
+    op.pooled = false;
+}
+
+TimerDriver::IntrusiveTimer::~IntrusiveTimer()
+{
+    driver.detachOp(op);
+}
+
+#ifdef __cpp_impl_coroutine
+TimerDriver::SleepAwaitable::SleepAwaitable(TimerDriver& driver,
+                                            Duration wait_time,
+                                            Duration slack)
+: driver{driver}, wait_time{wait_time}, slack{slack}, status{ErrorCode::Success}
+{
+}
+#endif
+
+TimerDriver::TimerDriver(Executor& executor,
+                         device::TimerDevice& device,
+                         Executor::Priority prio,
+                         QueueType queue_type,
+                         Mode mode)
+: executor{executor}, device{device}, prio{prio}, mode{mode},
+  tick_rate{device.getTickRate()}
+{
+    switch (queue_type) {
+        case QueueType::SortedList:
+            wait_queue = make_unique<SortedTimerList>();
+            break;
+        case QueueType::PairingHeap:
+            wait_queue = make_unique<PairingTimerHeap>();
+            break;
+    }
+
+    device.setWaitCompleteCallback(
+        [this](ErrorStatus&& status) { completeWait(move(status)); });
+
+    if (mode == Mode::FreeRunning) {
+        nb_deadline_channels = min(device.getNbDeadlineChannels(),
+                                   max_nb_deadline_channels);
+        if (nb_deadline_channels == 0) {
+            throw UnsupportedDeviceOperation{"setDeadline"};
+        }
+        device.startFreeRunning();
+    }
 }
 
 
@@ -41,16 +83,390 @@ TimerDriver::TimerDriver(EventLoop& event_loop, device::TimerDevice& device)
  * PRIVATE METHOD IMPLEMENTATIONS
  ******************************************************************************/
 
+TimerDriver::TimePoint TimerDriver::now()
+{
+    if (mode == Mode::FreeRunning) {
+        return device.getCounter();
+    }
+
+    /* The device only counts while a wait is armed, time stands still
+     * otherwise. This is fine as long as no wait operation is pending. */
+    if (!armed) {
+        return stopped_at;
+    }
+
+    return armed_deadline - device.getRemainingWaitTime();
+}
+
+uint64_t TimerDriver::toTicks(Duration duration, bool round_up) const
+{
+    return tick_rate.fromNanoseconds(duration.count(), round_up);
+}
+
+TimerDriver::WaitOp& TimerDriver::allocateOp()
+{
+    if (free_ops == nullptr) {
+        wait_ops.emplace_back();
+        WaitOp& op = wait_ops.back();
+
+        op.handle = Handle{static_cast<uint32_t>(wait_ops.size() - 1), 0};
+
+        return op;
+    }
+
+    WaitOp& op = *free_ops;
+    free_ops   = op.next_free;
+
+    return op;
+}
+
+void TimerDriver::freeOp(WaitOp& op)
+{
+    op.callback          = nullptr;
+    op.periodic_callback = nullptr;
+    op.period            = 0;
+    op.nb_overruns       = 0;
+    if (!op.pooled) {
+        /* The owner of the operation may arm it again right away */
+        return;
+    }
+    /* Invalidate the handles of this operation */
+    ++op.handle.generation;
+    op.next_free = free_ops;
+    free_ops     = &op;
+}
+
+bool TimerDriver::isNear(const WaitOp& op) const
+{
+    if (mode == Mode::OneShot) {
+        return wait_queue->front() == &op;
+    }
+
+    /* The operation may take a free channel or the one of a later deadline */
+    for (size_t i = 0; i < nb_deadline_channels; ++i) {
+        if (!channels[i].armed || op.deadline <= channels[i].deadline) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TimerDriver::disarm(TimePoint time)
+{
+    if (!armed) {
+        return;
+    }
+
+    device.cancelWait();
+    stopped_at = time;
+    armed      = false;
+}
+
+void TimerDriver::rearm(TimePoint time)
+{
+    /* Deadline channels are updated in place */
+    if (mode == Mode::OneShot) {
+        disarm(time);
+    }
+    arm(time);
+}
+
+void TimerDriver::expire(TimePoint time, ErrorCode code)
+{
+    TimerNode* node;
+
+    /* The queue is ordered by latest deadline: operations keep on expiring as
+     * long as the front one accepts to complete now, so that all the
+     * operations whose windows overlap are served by the same interrupt */
+    while ((node = wait_queue->front()) != nullptr
+           && static_cast<WaitOp*>(node)->earliest <= time) {
+        WaitOp& op = static_cast<WaitOp&>(*node);
+
+        wait_queue->remove(op);
+        ++statistics.nb_expirations;
+        if (op.deadline > time) {
+            ++statistics.nb_early_expirations;
+        }
+
+        if (op.period != 0) {
+            /* Periodic operations are re-armed from their previous deadline,
+             * skipping the ones that went past already */
+            uint64_t nb_overruns =
+                (time > op.deadline) ? (time - op.deadline) / op.period : 0;
+            op.deadline += (nb_overruns + 1) * op.period;
+            op.earliest = op.deadline;
+            op.nb_overruns += static_cast<unsigned>(nb_overruns);
+            wait_queue->insert(op);
+        }
+
+        completeOp(op, code);
+    }
+}
+
+void TimerDriver::arm(TimePoint time)
+{
+    /* Operations that expired while the device was stopped are completed
+     * right away */
+    expire(time, ErrorCode::Success);
+
+    if (mode == Mode::FreeRunning) {
+        armChannels();
+        return;
+    }
+
+    TimerNode* front = wait_queue->front();
+    if (front == nullptr) {
+        return;
+    }
+
+    /* Waits longer than the device range are split into epochs, the device is
+     * simply rearmed each time one of them ends */
+    uint64_t count =
+        min<uint64_t>(front->deadline - time, device.getMaxWaitCount());
+    device.startWait(static_cast<TimerDevice::TickCount>(count));
+    armed_deadline = time + count;
+    armed          = true;
+}
+
+void TimerDriver::armChannels()
+{
+    array<TimerNode*, max_nb_deadline_channels> nearest;
+    size_t nb_nearest =
+        wait_queue->nearest(nearest.data(), nb_deadline_channels);
+
+    /* Channels keep their deadline as long as it is one of the nearest ones,
+     * the others are released. Those that went off are released here too. */
+    for (size_t i = 0; i < nb_deadline_channels; ++i) {
+        if (!channels[i].armed) {
+            continue;
+        }
+
+        bool is_nearest = false;
+        for (size_t j = 0; j < nb_nearest; ++j) {
+            is_nearest |= (nearest[j]->deadline == channels[i].deadline);
+        }
+        if (!is_nearest) {
+            device.clearDeadline(i);
+            channels[i].armed = false;
+        }
+    }
+
+    /* Nearest deadlines that are not armed yet take the free channels. The
+     * device completes right away if a deadline went past since, its counter
+     * is already extended to 64 bits. */
+    size_t free_channel = 0;
+    for (size_t j = 0; j < nb_nearest; ++j) {
+        bool is_armed = false;
+        for (size_t i = 0; i < nb_deadline_channels; ++i) {
+            is_armed |= (channels[i].armed
+                         && channels[i].deadline == nearest[j]->deadline);
+        }
+        if (is_armed) {
+            continue;
+        }
+
+        /* Armed channels hold distinct nearest deadlines so there is always a
+         * free one left */
+        while (channels[free_channel].armed) { ++free_channel; }
+        device.setDeadline(free_channel, nearest[j]->deadline);
+        channels[free_channel].armed    = true;
+        channels[free_channel].deadline = nearest[j]->deadline;
+    }
+}
+
 void TimerDriver::completeWait(device::ErrorStatus&& status)
 {
-    if (wait_queue.front().callback) {
-        event_loop.pushEvent(bind(wait_queue.front().callback, status));
+    TimePoint time;
+
+    if (mode == Mode::FreeRunning) {
+        time = now();
+    } else {
+        /* The device stops once it went off */
+        time       = armed_deadline;
+        stopped_at = time;
+    }
+    armed = false;
+    ++statistics.nb_interrupts;
+
+    uint32_t nb_expirations = statistics.nb_expirations;
+    expire(time, status.get_code());
+    if (statistics.nb_expirations == nb_expirations) {
+        ++statistics.nb_epoch_interrupts;
+    }
+    arm(time);
+}
+
+void TimerDriver::completeOp(WaitOp& op, ErrorCode code)
+{
+    if (op.completed) {
+        /* The callback did not run yet: a periodic operation went off once
+         * more, or the operation was canceled in the meantime */
+        if (code == ErrorCode::Aborted) {
+            op.code = code;
+        } else {
+            ++op.nb_overruns;
+        }
+        return;
+    }
+
+    op.completed      = true;
+    op.code           = code;
+    op.next_completed = nullptr;
+
+    /* A single event runs all the callbacks completed until it is executed */
+    if (completed_tail == nullptr) {
+        completed_head = &op;
+        completed_tail = &op;
+        try {
+            executor.pushEvent([this]() { runCompletedOps(); }, prio);
+        } catch (...) {
+            /* The next completion must push the event again */
+            completed_head = nullptr;
+            completed_tail = nullptr;
+            op.completed   = false;
+            throw;
+        }
+        ++statistics.nb_events;
+    } else {
+        completed_tail->next_completed = &op;
+        completed_tail                 = &op;
+    }
+}
+
+void TimerDriver::runCompletedOps()
+{
+    while (true) {
+        if (!device.suspendWait()) {
+            throw CancelAsyncOpFailure{"Couldn't suspend wait on device"};
+        }
+
+        WaitOp* op = completed_head;
+        if (op == nullptr) {
+            device.resumeWait();
+            return;
+        }
+        completed_head = op->next_completed;
+        if (completed_head == nullptr) {
+            completed_tail = nullptr;
+        }
+        op->completed = false;
+
+        ErrorCode code = op->code;
+        ErrorStatus status{code};
+
+        if (op->period == 0) {
+            Callback callback = move(op->callback);
+            freeOp(*op);
+            device.resumeWait();
+
+            if (callback) {
+                callback(status);
+            }
+            continue;
+        }
+
+        unsigned nb_overruns = op->nb_overruns;
+        op->nb_overruns      = 0;
+        device.resumeWait();
+
+        /* The callback stays with a periodic operation for the next periods.
+         * It may cancel the operation, which then completes once more. */
+        if (code == ErrorCode::Aborted) {
+            if (op->periodic_callback) {
+                op->periodic_callback(status, 0);
+            }
+
+            if (!device.suspendWait()) {
+                throw CancelAsyncOpFailure{"Couldn't suspend wait on device"};
+            }
+            freeOp(*op);
+            device.resumeWait();
+        } else if (op->periodic_callback) {
+            op->periodic_callback(status, nb_overruns);
+        }
+    }
+}
+
+void TimerDriver::queueOp(WaitOp& op, uint64_t wait_ticks, uint64_t slack_ticks)
+{
+    TimePoint time = now();
+
+    op.deadline = time + wait_ticks;
+    op.earliest = op.deadline - min(slack_ticks, wait_ticks);
+    wait_queue->insert(op);
+
+    if (isNear(op)) {
+        /* The new operation is one of the next to expire, the device must be
+         * reprogrammed */
+        rearm(time);
+    }
+}
+
+TimerDriver::Timer TimerDriver::addWait(Duration wait_time,
+                                        Duration slack,
+                                        Callback&& event_callback)
+{
+    /* Disable Timer IRQ: We don't want the timer callback accessing internal
+     * class data while we're adding this wait op */
+    if (!device.suspendWait()) {
+        throw StartAsyncOpFailure{"Couldn't suspend running wait on device"};
+    }
+
+    WaitOp& op  = allocateOp();
+    op.callback = move(event_callback);
+    queueOp(op, toTicks(wait_time, true), toTicks(slack, false));
+
+    device.resumeWait();
+
+    return Timer{*this, op.handle};
+}
+
+TimerDriver::Timer TimerDriver::addPeriodicWait(
+    Duration period,
+    PeriodicCallback&& event_callback)
+{
+    if (period == Duration::zero()) {
+        throw StartAsyncOpFailure{"Period must not be null"};
+    }
+
+    /* Disable Timer IRQ: We don't want the timer callback accessing internal
+     * class data while we're adding this wait op */
+    if (!device.suspendWait()) {
+        throw StartAsyncOpFailure{"Couldn't suspend running wait on device"};
+    }
+
+    WaitOp& op           = allocateOp();
+    op.periodic_callback = move(event_callback);
+    op.period            = toTicks(period, true);
+    queueOp(op, op.period, 0);
+
+    device.resumeWait();
+
+    return Timer{*this, op.handle};
+}
+
+void TimerDriver::addIntrusiveWait(WaitOp& op,
+                                   Duration wait_time,
+                                   Duration slack,
+                                   Callback&& event_callback)
+{
+    /* Disable Timer IRQ: We don't want the timer callback accessing internal
+     * class data while we're adding this wait op */
+    if (!device.suspendWait()) {
+        throw StartAsyncOpFailure{"Couldn't suspend running wait on device"};
     }
-    wait_queue.pop_front();
 
-    if (!wait_queue.empty()) {
-        device.startWait(wait_queue.front().wait_time.count());
+    /* The operation is busy until its callback ran */
+    if (op.queued || op.completed) {
+        device.resumeWait();
+        throw StartAsyncOpFailure{"Timer is already pending"};
     }
+
+    op.callback = move(event_callback);
+    queueOp(op, toTicks(wait_time, true), toTicks(slack, false));
+
+    device.resumeWait();
 }
 
 void TimerDriver::cancelWait(Handle handle)
@@ -61,64 +477,106 @@ void TimerDriver::cancelWait(Handle handle)
         throw CancelAsyncOpFailure{"Couldn't suspend wait on device"};
     }
 
-    if (wait_queue.empty()) {
-        /* Nothing to cancel, maybe the timer already went off and it was the
-         * only one? */
+    if (handle.index >= wait_ops.size()) {
         device.resumeWait();
-        throw CancelAsyncOpFailure{"Nothing to cancel"};
+        throw CancelAsyncOpFailure{"Invalid wait operation handle"};
     }
 
-    if (wait_queue.front().handle == handle) {
-        TimerDevice::WaitTimeUnitDuration canceled_wait_time =
-            device.getRemainingWaitTime();
-        /* This wait operation has already started, ask the device for
-         * cancelation */
-        if (!device.cancelWait()) {
-            /* Too late */
-            device.resumeWait();
-            throw CancelAsyncOpFailure{"Couldn't cancel wait operation"};
-        }
-        /* The operation was cancelled and the completion handler won't be
-         * called, signal the aborted event to the loop */
-        if (wait_queue.front().callback) {
-            event_loop.pushEvent(bind(wait_queue.front().callback,
-                                      ErrorStatus{ErrorCode::Aborted}));
+    WaitOp& op = wait_ops[handle.index];
+    if (op.handle.generation != handle.generation || !op.queued) {
+        /* The wait operation was already executed, its slot may even have been
+         * reused since */
+        device.resumeWait();
+        throw CancelAsyncOpFailure{"Wait operation was already exec'd"};
+    }
+
+    abortOp(op);
+
+    device.resumeWait();
+}
+
+bool TimerDriver::cancelIntrusiveWait(WaitOp& op)
+{
+    /* Disable Timer IRQ: We don't want the timer callback accessing internal
+     * class data while we're removing this wait op */
+    if (!device.suspendWait()) {
+        throw CancelAsyncOpFailure{"Couldn't suspend wait on device"};
+    }
+
+    bool was_queued = op.queued;
+    if (was_queued) {
+        abortOp(op);
+    }
+
+    device.resumeWait();
+
+    return was_queued;
+}
+
+void TimerDriver::abortOp(WaitOp& op)
+{
+    TimePoint time = now();
+    bool was_near  = isNear(op);
+
+    wait_queue->remove(op);
+    /* The operation was cancelled and the completion handler won't be called,
+     * signal the aborted event to the loop */
+    completeOp(op, ErrorCode::Aborted);
+
+    if (was_near) {
+        rearm(time);
+    }
+}
+
+void TimerDriver::detachOp(WaitOp& op) noexcept
+{
+    /* The operation must be unlinked whatever happens, the device is at
+     * worst left without the next wait armed */
+    TimePoint time = 0;
+    bool was_near  = false;
+    try {
+        device.suspendWait();
+        if (op.queued) {
+            time     = now();
+            was_near = isNear(op);
         }
-        wait_queue.pop_front();
+    } catch (...) {
+    }
+
+    if (op.queued) {
+        wait_queue->remove(op);
+    }
 
-        if (!wait_queue.empty()) {
-            device.startWait(
-                (wait_queue.front().wait_time + canceled_wait_time).count());
+    if (op.completed) {
+        /* Completed operations are few, the list is simply walked */
+        WaitOp* prev = nullptr;
+        WaitOp* it   = completed_head;
+        while (it != &op) {
+            prev = it;
+            it   = it->next_completed;
         }
-    } else {
-        /* The wait operation hasn't started, or maybe it was already executed.
-         * We'll remove it from the wait queue & add its wait time to the
-         * request that was supposed to run after it */
-        auto it =
-            find_if(++wait_queue.begin(), wait_queue.end(),
-                    [handle](const WaitOp& op) { return op.handle == handle; });
-        if (it == wait_queue.end()) {
-            /* The handle does not exist, the wait operation was already
-             * executed */
-            device.resumeWait();
-            throw CancelAsyncOpFailure{"Wait operation was already exec'd"};
+
+        if (prev != nullptr) {
+            prev->next_completed = op.next_completed;
         } else {
-            TimerDevice::WaitTimeUnitDuration canceled_wait_time =
-                it->wait_time;
-            /* The operation was cancelled and the completion handler won't be
-             * called, signal the aborted event to the loop */
-            if (it->callback) {
-                event_loop.pushEvent(
-                    bind(it->callback, ErrorStatus{ErrorCode::Aborted}));
-            }
-            it = wait_queue.erase(it);
-            if (it != wait_queue.end()) {
-                it->wait_time += canceled_wait_time;
-            }
+            completed_head = op.next_completed;
         }
+        if (completed_tail == &op) {
+            completed_tail = prev;
+        }
+        op.completed = false;
     }
 
-    device.resumeWait();
+    try {
+        if (was_near) {
+            rearm(time);
+        }
+    } catch (...) {
+    }
+    try {
+        device.resumeWait();
+    } catch (...) {
+    }
 }
 
 
@@ -134,3 +592,51 @@ void TimerDriver::Timer::cancelWait()
 {
     owner.cancelWait(handle);
 }
+
+size_t TimerDriver::getNbPendingWaits() const
+{
+    /* Only used as a hint, it does not matter if it is outdated */
+    return wait_queue->size();
+}
+
+bool TimerDriver::IntrusiveTimer::cancelWait()
+{
+    return driver.cancelIntrusiveWait(op);
+}
+
+bool TimerDriver::IntrusiveTimer::isPending() const
+{
+    return op.queued;
+}
+
+TimerDriver::Statistics TimerDriver::getStatistics()
+{
+    /* Each counter is read atomically, they may only be off by one between
+     * each other which is fine for statistics */
+    return statistics;
+}
+
+#ifdef __cpp_impl_coroutine
+bool TimerDriver::SleepAwaitable::await_suspend(coroutine_handle<> handle)
+{
+    /* An exception raised here would reach the coroutine promise, which
+     * terminates: report it from await_resume instead */
+    try {
+        driver.addWait(wait_time, slack,
+                       [this, handle](ErrorStatus& wait_status) {
+                           status = wait_status;
+                           handle.resume();
+                       });
+    } catch (...) {
+        status = ErrorCode::Failure;
+        return false;
+    }
+
+    return true;
+}
+
+ErrorStatus TimerDriver::SleepAwaitable::await_resume() const noexcept
+{
+    return status;
+}
+#endif
@@ -11,9 +11,16 @@
  * INCLUDE DIRECTIVES
  ******************************************************************************/
 
+#include "timer_queue.hpp"
+
+#include <array>
 #include <chrono>
+#include <coroutine.hpp>
+#include <cstdint>
+#include <deque>
 #include <device/timer_device.hpp>
 #include <event_loop.hpp>
+#include <memory>
 
 namespace hal
 {
@@ -26,9 +33,60 @@ namespace driver
 class TimerDriver
 {
   public:
-    TimerDriver(EventLoop& event_loop, device::TimerDevice& device);
+    typedef InplaceFunction<void(device::ErrorStatus&), callback_capacity>
+        Callback;
+    typedef InplaceFunction<void(device::ErrorStatus&, unsigned),
+                            callback_capacity>
+        PeriodicCallback;
+
+    /** Wait times are handled in ns on 64 bits, they are converted to ticks
+     * at the rate of the device, see @ref device::TimerDevice::getTickRate */
+    typedef std::chrono::duration<uint64_t, std::nano> Duration;
+
+    /** Data structure holding the pending wait operations */
+    enum class QueueType {
+        /* O(1) insertion when deadlines are mostly increasing, O(n) in the
+         * worst case. O(1) cancelation. Best for a few timers. */
+        SortedList,
+        /* O(1) insertion, O(log n) amortized cancelation and expiry. Best for
+         * hundreds of timers with random deadlines. */
+        PairingHeap
+    };
+
+    /** How the device keeps track of time */
+    enum class Mode {
+        /* The device counter is restarted for each wait operation. Any timer
+         * device may be used but the time spent reprogramming it is lost. */
+        OneShot,
+        /* The device counter runs free and wait operations are programmed as
+         * absolute deadlines so no time is ever lost. Up to four of the
+         * nearest deadlines are armed at once, one per compare channel. The
+         * device must support @ref device::TimerDevice::startFreeRunning. */
+        FreeRunning
+    };
 
-    typedef unsigned Handle;
+    /** @param executor
+     *  Runs the events published by this driver, either the EventLoop or an
+     * InterruptExecutor
+     * @param prio
+     *  Priority of these events within the executor. Timer events are time
+     * critical so they default to the highest one.
+     * @param queue_type
+     *  Data structure used to sort pending wait operations
+     * @param mode
+     *  How the device keeps track of time */
+    TimerDriver(Executor& executor,
+                device::TimerDevice& device,
+                Executor::Priority prio = EventLoop::highest_priority,
+                QueueType queue_type    = QueueType::SortedList,
+                Mode mode               = Mode::OneShot);
+
+    /** Identifies a wait operation, the generation tells apart successive
+     * operations stored in the same slot */
+    struct Handle {
+        uint32_t index;
+        uint32_t generation;
+    };
 
     class Timer
     {
@@ -42,6 +100,9 @@ class TimerDriver
         Handle handle;
     };
 
+    /** A one-shot timer whose storage is owned by the caller, see below */
+    class IntrusiveTimer;
+
     /** Start an asynchronous wait operation
      * @param timeout
      *  The wait time
@@ -51,25 +112,237 @@ class TimerDriver
      * indicating if the wait operation succeeded or not. */
     template<typename TRep, typename TPeriod>
     Timer asyncWait(const std::chrono::duration<TRep, TPeriod>& timeout,
-                    std::function<void(device::ErrorStatus&)>&& event_callback);
+                    Callback&& event_callback);
+
+    /** Same as above, but the wait operation may complete up to slack earlier
+     * than the wait time. Timers whose windows overlap are then served by a
+     * single device interrupt and their callbacks run from a single event.
+     * @param timeout
+     *  The latest the wait operation may complete
+     * @param slack
+     *  How much earlier than timeout the wait operation may complete */
+    template<typename TRep,
+             typename TPeriod,
+             typename TSlackRep,
+             typename TSlackPeriod>
+    Timer asyncWait(const std::chrono::duration<TRep, TPeriod>& timeout,
+                    const std::chrono::duration<TSlackRep, TSlackPeriod>& slack,
+                    Callback&& event_callback);
+
+    /** Start a periodic wait operation, it runs until canceled through the
+     * returned timer. Each deadline is derived from the previous one rather
+     * than from the time the callback ran, so latency does not accumulate.
+     * @param period
+     *  The time between two deadlines, must not be null
+     * @param event_callback
+     *  The event that will be pushed to the event loop at each deadline. This
+     * callback will receive an error status as parameter, indicating if the
+     * wait operation succeeded or was canceled, as well as the number of
+     * deadlines that were skipped since the previous call because the timer
+     * went off too late. */
+    template<typename TRep, typename TPeriod>
+    Timer asyncWaitPeriodic(const std::chrono::duration<TRep, TPeriod>& period,
+                            PeriodicCallback&& event_callback);
+
+    /** Counters showing how well wait operations are coalesced. The number of
+     * interrupts saved is nb_expirations - (nb_interrupts -
+     * nb_epoch_interrupts). */
+    struct Statistics {
+        /* Device interrupts handled */
+        uint32_t nb_interrupts = 0;
+        /* Wait operations that went off, including each period */
+        uint32_t nb_expirations = 0;
+        /* Wait operations that went off before their timeout thanks to their
+         * slack */
+        uint32_t nb_early_expirations = 0;
+        /* Events pushed to the executor, each runs a batch of callbacks */
+        uint32_t nb_events = 0;
+        /* Device interrupts that did not expire anything, they only marked
+         * the end of an epoch of a wait longer than the device range */
+        uint32_t nb_epoch_interrupts = 0;
+    };
+
+    Statistics getStatistics();
+
+    /** @return The number of wait operations that did not go off yet */
+    size_t getNbPendingWaits() const;
+
+#ifdef __cpp_impl_coroutine
+    /** Awaitable returned by @ref sleep. The awaiting coroutine is resumed by
+     * the executor of the driver once the wait time is finished. */
+    class SleepAwaitable
+    {
+      public:
+        SleepAwaitable(TimerDriver& driver,
+                       Duration wait_time,
+                       Duration slack = Duration::zero());
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+        /** Resumes the coroutine at once with a Failure status if the wait
+         * cannot be started, e.g. when the device rejects it */
+        bool await_suspend(std::coroutine_handle<> handle);
+        device::ErrorStatus await_resume() const noexcept;
+
+      private:
+        TimerDriver& driver;
+        Duration wait_time;
+        Duration slack;
+        device::ErrorStatus status;
+    };
+
+    /** Same as @ref asyncWait but to be awaited from a coroutine:
+     * auto status = co_await timer_driver.sleep(10ms); */
+    template<typename TRep, typename TPeriod>
+    SleepAwaitable sleep(const std::chrono::duration<TRep, TPeriod>& timeout);
+    template<typename TRep,
+             typename TPeriod,
+             typename TSlackRep,
+             typename TSlackPeriod>
+    SleepAwaitable
+        sleep(const std::chrono::duration<TRep, TPeriod>& timeout,
+              const std::chrono::duration<TSlackRep, TSlackPeriod>& slack);
+#endif
 
   private:
-    struct WaitOp {
+    /* Number of device ticks elapsed since the driver was created */
+    typedef uint64_t TimePoint;
+
+    /* The node deadline is the latest time at which the operation may
+     * complete, the queue is thus ordered by latest deadline */
+    struct WaitOp : TimerNode {
         Handle handle;
-        device::TimerDevice::WaitTimeUnitDuration wait_time;
-        std::function<void(device::ErrorStatus&)> callback;
+        /* Earliest time at which the operation may complete */
+        TimePoint earliest = 0;
+        Callback callback;
+        /* Only used by periodic operations, which have a non-null period */
+        PeriodicCallback periodic_callback;
+        /* In device ticks */
+        uint64_t period = 0;
+        /* Set while the operation waits in the completed list for its
+         * callback to run */
+        bool completed         = false;
+        device::ErrorCode code = device::ErrorCode::Success;
+        unsigned nb_overruns   = 0;
+        WaitOp* next_completed = nullptr;
+        /* Intrusive timers own their operation, it never goes to the pool */
+        bool pooled = true;
+        /* Chains unused operations together */
+        WaitOp* next_free = nullptr;
     };
 
-    EventLoop& event_loop;
+    Executor& executor;
     device::TimerDevice& device;
-    std::list<WaitOp> wait_queue;
-    Handle next_handle;
+    const Executor::Priority prio;
+    const Mode mode;
+    const device::TimerDevice::TickRate tick_rate;
+    std::unique_ptr<TimerQueue> wait_queue;
+    /* Wait operations are recycled but never freed so that stale handles can
+     * always be checked against their slot */
+    std::deque<WaitOp> wait_ops;
+    WaitOp* free_ops = nullptr;
+    /* Operations whose callback must run, in completion order */
+    WaitOp* completed_head = nullptr;
+    WaitOp* completed_tail = nullptr;
+    Statistics statistics;
+    /* Whether the device is counting towards armed_deadline. It may be
+     * earlier than the front deadline when the latter is out of the device
+     * range. */
+    bool armed               = false;
+    TimePoint armed_deadline = 0;
+    /* Time at which the device was last stopped, only used in OneShot mode */
+    TimePoint stopped_at = 0;
+
+    /* In FreeRunning mode, the nearest deadlines are armed at once on the
+     * compare channels of the device */
+    static constexpr size_t max_nb_deadline_channels = 4;
+
+    struct DeadlineChannel {
+        bool armed         = false;
+        TimePoint deadline = 0;
+    };
+
+    size_t nb_deadline_channels = 0;
+    std::array<DeadlineChannel, max_nb_deadline_channels> channels;
 
     friend Timer;
+    friend IntrusiveTimer;
+    friend class TimerDriverPool;
 
+    template<typename TRep, typename TPeriod>
+    static Duration toDuration(const std::chrono::duration<TRep, TPeriod>& d);
+    template<typename TRep, typename TPeriod>
+    static Duration toSlack(const std::chrono::duration<TRep, TPeriod>& d);
+
+    TimePoint now();
+    Timer addWait(Duration wait_time,
+                  Duration slack,
+                  Callback&& event_callback);
+    Timer addPeriodicWait(Duration period, PeriodicCallback&& event_callback);
+    void addIntrusiveWait(WaitOp& op,
+                          Duration wait_time,
+                          Duration slack,
+                          Callback&& event_callback);
+    uint64_t toTicks(Duration duration, bool round_up) const;
+    void queueOp(WaitOp& op, uint64_t wait_ticks, uint64_t slack_ticks);
+    WaitOp& allocateOp();
+    void freeOp(WaitOp& op);
+    bool isNear(const WaitOp& op) const;
+    void disarm(TimePoint time);
+    void rearm(TimePoint time);
+    void expire(TimePoint time, device::ErrorCode code);
+    void arm(TimePoint time);
+    void armChannels();
     void completeWait(device::ErrorStatus&& status);
     void cancelWait(Handle handle);
-};  // namespace driver
+    bool cancelIntrusiveWait(WaitOp& op);
+    void abortOp(WaitOp& op);
+    /** Unlink an operation about to be destroyed, failures to reprogram the
+     * device are not reported */
+    void detachOp(WaitOp& op) noexcept;
+    void completeOp(WaitOp& op, device::ErrorCode code);
+    void runCompletedOps();
+};
+
+/** A one-shot timer holding its own queue hooks and callback: arming and
+ * cancelling it never allocates memory. It may be armed again once its
+ * callback ran, including from that callback. Destroying a pending timer
+ * drops its wait operation without calling its callback. */
+class TimerDriver::IntrusiveTimer
+{
+  public:
+    IntrusiveTimer(TimerDriver& driver);
+    ~IntrusiveTimer();
+
+    IntrusiveTimer(const IntrusiveTimer&) = delete;
+    IntrusiveTimer& operator=(const IntrusiveTimer&) = delete;
+
+    /** Same as @ref TimerDriver::asyncWait
+     * @throw StartAsyncOpFailure if the timer is already pending */
+    template<typename TRep, typename TPeriod>
+    void asyncWait(const std::chrono::duration<TRep, TPeriod>& timeout,
+                   Callback&& event_callback);
+    template<typename TRep,
+             typename TPeriod,
+             typename TSlackRep,
+             typename TSlackPeriod>
+    void asyncWait(const std::chrono::duration<TRep, TPeriod>& timeout,
+                   const std::chrono::duration<TSlackRep, TSlackPeriod>& slack,
+                   Callback&& event_callback);
+
+    /** @return false if no wait operation was pending, otherwise its callback
+     * will be called with an aborted status */
+    bool cancelWait();
+
+    /** @return Whether a wait operation is armed and did not go off yet */
+    bool isPending() const;
+
+  private:
+    TimerDriver& driver;
+    WaitOp op;
+};
 
 }  // namespace driver
 }  // namespace hal
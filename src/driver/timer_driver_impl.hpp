@@ -12,75 +12,97 @@
 
 
 /*******************************************************************************
- * PUBLIC METHOD IMPLEMENTATIONS
+ * PRIVATE METHOD IMPLEMENTATIONS
  ******************************************************************************/
 
 template<typename TRep, typename TPeriod>
-hal::driver::TimerDriver::Timer hal::driver::TimerDriver::asyncWait(
-    const std::chrono::duration<TRep, TPeriod>& wait_time,
-    std::function<void(hal::device::ErrorStatus&)>&& event_callback)
+hal::driver::TimerDriver::Duration hal::driver::TimerDriver::toDuration(
+    const std::chrono::duration<TRep, TPeriod>& d)
 {
-    using namespace std;
-    using namespace hal::device;
+    /* Round up: a wait operation may complete late but never early */
+    return (d > d.zero()) ? std::chrono::ceil<Duration>(d) : Duration::zero();
+}
 
-    Handle handle = next_handle++;
-    Timer timer{*this, handle};
+template<typename TRep, typename TPeriod>
+hal::driver::TimerDriver::Duration hal::driver::TimerDriver::toSlack(
+    const std::chrono::duration<TRep, TPeriod>& d)
+{
+    /* Round down: a wait operation never completes earlier than allowed */
+    return (d > d.zero()) ? std::chrono::floor<Duration>(d) : Duration::zero();
+}
 
-    /* Disable Timer IRQ: We don't want the timer callback accessing internal
-     * class data while we're adding this wait op */
-    if (!device.suspendWait()) {
-        throw StartAsyncOpFailure{"Couldn't suspend running wait on device"};
-    }
+/*******************************************************************************
+ * PUBLIC METHOD IMPLEMENTATIONS
+ ******************************************************************************/
 
-    TimerDevice::WaitTimeUnitDuration dev_wait_duration =
-        chrono::duration_cast<TimerDevice::WaitTimeUnitDuration>(wait_time);
+template<typename TRep, typename TPeriod>
+hal::driver::TimerDriver::Timer hal::driver::TimerDriver::asyncWait(
+    const std::chrono::duration<TRep, TPeriod>& wait_time,
+    Callback&& event_callback)
+{
+    return addWait(toDuration(wait_time), Duration::zero(),
+                   std::move(event_callback));
+}
 
-    if (wait_queue.empty()) {
-        wait_queue.push_front(
-            WaitOp{handle, dev_wait_duration, event_callback});
-        device.startWait(dev_wait_duration.count());
-        return timer;
-    }
+template<typename TRep,
+         typename TPeriod,
+         typename TSlackRep,
+         typename TSlackPeriod>
+hal::driver::TimerDriver::Timer hal::driver::TimerDriver::asyncWait(
+    const std::chrono::duration<TRep, TPeriod>& wait_time,
+    const std::chrono::duration<TSlackRep, TSlackPeriod>& slack,
+    Callback&& event_callback)
+{
+    return addWait(toDuration(wait_time), toSlack(slack),
+                   std::move(event_callback));
+}
 
-    /* Another wait operation is running, we need to schedule the new one for
-     * later */
-    TimerDevice::WaitTimeUnitDuration remaining_wait_time =
-        device.getRemainingWaitTime();
+template<typename TRep, typename TPeriod>
+hal::driver::TimerDriver::Timer hal::driver::TimerDriver::asyncWaitPeriodic(
+    const std::chrono::duration<TRep, TPeriod>& period,
+    PeriodicCallback&& event_callback)
+{
+    return addPeriodicWait(toDuration(period), std::move(event_callback));
+}
 
-    if (remaining_wait_time > dev_wait_duration) {
-        /* The running wait is longer than what we need, cancel it and
-         * reschedule it for later */
-        if (!device.cancelWait()) {
-            /* We cannot go further */
-            device.resumeWait();
-            throw StartAsyncOpFailure{"Couldn't reschedule wait on device"};
-        }
+template<typename TRep, typename TPeriod>
+void hal::driver::TimerDriver::IntrusiveTimer::asyncWait(
+    const std::chrono::duration<TRep, TPeriod>& wait_time,
+    Callback&& event_callback)
+{
+    driver.addIntrusiveWait(op, toDuration(wait_time), Duration::zero(),
+                            std::move(event_callback));
+}
 
-        wait_queue.front().wait_time = remaining_wait_time - dev_wait_duration;
-        wait_queue.push_front(
-            WaitOp{handle, dev_wait_duration, event_callback});
-        device.startWait(dev_wait_duration.count());
-    } else {
-        /* The new wait op won't be started immediately. We need to
-         * schedule it:
-         * - Substract from this request's duration the duration of all wait
-         *      operations that will be executed before this one
-         * - Insert the operation in the wait queue
-         * - Substract the remaining time to other operations that will be
-         * executed after this one */
-        auto it = wait_queue.begin();
-        while (dev_wait_duration > it->wait_time && it != wait_queue.end()) {
-            dev_wait_duration -= it->wait_time;
-            ++it;
-        }
-        wait_queue.insert(it,
-                          WaitOp{handle, dev_wait_duration, event_callback});
-        if (it != wait_queue.end()) {
-            it->wait_time -= dev_wait_duration;
-        }
+template<typename TRep,
+         typename TPeriod,
+         typename TSlackRep,
+         typename TSlackPeriod>
+void hal::driver::TimerDriver::IntrusiveTimer::asyncWait(
+    const std::chrono::duration<TRep, TPeriod>& wait_time,
+    const std::chrono::duration<TSlackRep, TSlackPeriod>& slack,
+    Callback&& event_callback)
+{
+    driver.addIntrusiveWait(op, toDuration(wait_time), toSlack(slack),
+                            std::move(event_callback));
+}
 
-        device.resumeWait();
-    }
+#ifdef __cpp_impl_coroutine
+template<typename TRep, typename TPeriod>
+hal::driver::TimerDriver::SleepAwaitable hal::driver::TimerDriver::sleep(
+    const std::chrono::duration<TRep, TPeriod>& timeout)
+{
+    return SleepAwaitable{*this, toDuration(timeout)};
+}
 
-    return timer;
+template<typename TRep,
+         typename TPeriod,
+         typename TSlackRep,
+         typename TSlackPeriod>
+hal::driver::TimerDriver::SleepAwaitable hal::driver::TimerDriver::sleep(
+    const std::chrono::duration<TRep, TPeriod>& timeout,
+    const std::chrono::duration<TSlackRep, TSlackPeriod>& slack)
+{
+    return SleepAwaitable{*this, toDuration(timeout), toSlack(slack)};
 }
+#endif
@@ -0,0 +1,115 @@
+
+/*******************************************************************************
+ * Implementation file of the TimerDriverPool class
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "timer_driver_pool.hpp"
+
+#include "driver_exceptions.hpp"
+
+#include <algorithm>
+
+using namespace std;
+using namespace hal::driver;
+using namespace hal::device;
+
+
+/*******************************************************************************
+ * CONSTRUCTORS & DESTRUCTOR
+ ******************************************************************************/
+
+TimerDriverPool::TimerDriverPool(
+    Executor& executor,
+    initializer_list<reference_wrapper<TimerDevice>> devices,
+    Executor::Priority prio,
+    TimerDriver::QueueType queue_type,
+    TimerDriver::Mode mode)
+{
+    if (devices.size() == 0) {
+        throw EmptyTimerDriverPoolException{};
+    }
+
+    /* Devices may tick at different rates, their ranges are compared in
+     * time rather than in ticks */
+    auto getRange = [](TimerDevice& device) {
+        return Duration{
+            device.getTickRate().toNanoseconds(device.getMaxWaitCount())};
+    };
+    Duration widest_range    = Duration::zero();
+    Duration narrowest_range = Duration::max();
+
+    for (TimerDevice& device : devices) {
+        widest_range    = max(widest_range, getRange(device));
+        narrowest_range = min(narrowest_range, getRange(device));
+    }
+
+    members.reserve(devices.size());
+    for (TimerDevice& device : devices) {
+        members.push_back(Member{
+            make_unique<TimerDriver>(executor, device, prio, queue_type, mode),
+            getRange(device) == widest_range});
+    }
+
+    short_wait_threshold = narrowest_range;
+}
+
+
+/*******************************************************************************
+ * OPERATOR IMPLEMENTATIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PRIVATE METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+TimerDriver& TimerDriverPool::selectDriver(Duration wait_time, Duration slack)
+{
+    /* Precise waits go to the timers that never need to split them, the others
+     * are kept away from these timers if possible */
+    bool is_precise =
+        (slack == Duration::zero() && wait_time <= short_wait_threshold);
+    Member* best       = nullptr;
+    size_t best_nb_ops = 0;
+
+    for (Member& member : members) {
+        size_t nb_ops = member.driver->getNbPendingWaits();
+
+        bool is_better;
+        if (best == nullptr) {
+            is_better = true;
+        } else if (best->is_wide != member.is_wide) {
+            is_better = (member.is_wide == is_precise);
+        } else {
+            is_better = (nb_ops < best_nb_ops);
+        }
+
+        if (is_better) {
+            best        = &member;
+            best_nb_ops = nb_ops;
+        }
+    }
+
+    return *best->driver;
+}
+
+/*******************************************************************************
+ * PROTECTED METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PUBLIC METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+size_t TimerDriverPool::getNbDrivers() const
+{
+    return members.size();
+}
+
+TimerDriver& TimerDriverPool::getDriver(size_t index)
+{
+    return *members.at(index).driver;
+}
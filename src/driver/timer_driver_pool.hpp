@@ -0,0 +1,99 @@
+
+/*******************************************************************************
+ * Spreads wait operations over several timer devices, each one served by its
+ * own TimerDriver. Short waits that must be precise go to the widest timers,
+ * e.g. the 32-bit TIM2 & TIM5, while long or coarse ones go to the narrower
+ * timers. Within each group, the driver with the fewest pending waits is
+ * chosen so that no single timer IRQ becomes a hotspot.
+ ******************************************************************************/
+
+#ifndef _HAL_DRIVER_TIMER_DRIVER_POOL_HPP
+#define _HAL_DRIVER_TIMER_DRIVER_POOL_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "timer_driver.hpp"
+
+#include <chrono>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+namespace hal
+{
+namespace driver
+{
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+class TimerDriverPool
+{
+  public:
+    typedef TimerDriver::Callback Callback;
+    typedef TimerDriver::PeriodicCallback PeriodicCallback;
+    typedef TimerDriver::Duration Duration;
+    typedef TimerDriver::Timer Timer;
+
+    /** Build one TimerDriver per device, the other parameters are the same as
+     * @ref TimerDriver::TimerDriver and are shared by all the drivers.
+     * @param devices
+     *  Timer devices to spread the wait operations on, at least one */
+    TimerDriverPool(
+        Executor& executor,
+        std::initializer_list<std::reference_wrapper<device::TimerDevice>>
+            devices,
+        Executor::Priority prio          = EventLoop::highest_priority,
+        TimerDriver::QueueType queue_type = TimerDriver::QueueType::SortedList,
+        TimerDriver::Mode mode            = TimerDriver::Mode::OneShot);
+
+    /** Same as @ref TimerDriver::asyncWait, the returned timer is bound to the
+     * driver the wait operation was routed to */
+    template<typename TRep, typename TPeriod>
+    Timer asyncWait(const std::chrono::duration<TRep, TPeriod>& timeout,
+                    Callback&& event_callback);
+    template<typename TRep,
+             typename TPeriod,
+             typename TSlackRep,
+             typename TSlackPeriod>
+    Timer asyncWait(const std::chrono::duration<TRep, TPeriod>& timeout,
+                    const std::chrono::duration<TSlackRep, TSlackPeriod>& slack,
+                    Callback&& event_callback);
+    /** Same as @ref TimerDriver::asyncWaitPeriodic, the period is routed as a
+     * precise wait */
+    template<typename TRep, typename TPeriod>
+    Timer asyncWaitPeriodic(const std::chrono::duration<TRep, TPeriod>& period,
+                            PeriodicCallback&& event_callback);
+
+    /** Waits without slack up to this duration are routed to the widest
+     * timers. It defaults to the range of the narrowest timer. */
+    template<typename TRep, typename TPeriod>
+    void setShortWaitThreshold(
+        const std::chrono::duration<TRep, TPeriod>& threshold);
+
+    size_t getNbDrivers() const;
+    /** Give access to the statistics of each driver */
+    TimerDriver& getDriver(size_t index);
+
+  private:
+    struct Member {
+        std::unique_ptr<TimerDriver> driver;
+        /* Whether the device has the widest range of the pool */
+        bool is_wide;
+    };
+
+    std::vector<Member> members;
+    Duration short_wait_threshold;
+
+    TimerDriver& selectDriver(Duration wait_time, Duration slack);
+};
+
+}  // namespace driver
+}  // namespace hal
+
+#include "timer_driver_pool_impl.hpp"
+
+#endif
@@ -0,0 +1,61 @@
+
+/*******************************************************************************
+ * Implementation file for timer driver pool templated functions
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "timer_driver_pool.hpp"
+
+
+/*******************************************************************************
+ * PUBLIC METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+template<typename TRep, typename TPeriod>
+hal::driver::TimerDriverPool::Timer hal::driver::TimerDriverPool::asyncWait(
+    const std::chrono::duration<TRep, TPeriod>& wait_time,
+    Callback&& event_callback)
+{
+    Duration duration = TimerDriver::toDuration(wait_time);
+
+    return selectDriver(duration, Duration::zero())
+        .addWait(duration, Duration::zero(), std::move(event_callback));
+}
+
+template<typename TRep,
+         typename TPeriod,
+         typename TSlackRep,
+         typename TSlackPeriod>
+hal::driver::TimerDriverPool::Timer hal::driver::TimerDriverPool::asyncWait(
+    const std::chrono::duration<TRep, TPeriod>& wait_time,
+    const std::chrono::duration<TSlackRep, TSlackPeriod>& slack,
+    Callback&& event_callback)
+{
+    Duration duration   = TimerDriver::toDuration(wait_time);
+    Duration slack_time = TimerDriver::toSlack(slack);
+
+    return selectDriver(duration, slack_time)
+        .addWait(duration, slack_time, std::move(event_callback));
+}
+
+template<typename TRep, typename TPeriod>
+hal::driver::TimerDriverPool::Timer
+    hal::driver::TimerDriverPool::asyncWaitPeriodic(
+        const std::chrono::duration<TRep, TPeriod>& period,
+        PeriodicCallback&& event_callback)
+{
+    Duration duration = TimerDriver::toDuration(period);
+
+    return selectDriver(duration, Duration::zero())
+        .addPeriodicWait(duration, std::move(event_callback));
+}
+
+template<typename TRep, typename TPeriod>
+void hal::driver::TimerDriverPool::setShortWaitThreshold(
+    const std::chrono::duration<TRep, TPeriod>& threshold)
+{
+    short_wait_threshold = TimerDriver::toDuration(threshold);
+}
@@ -0,0 +1,220 @@
+
+/*******************************************************************************
+ * Implementation file of the timer queues
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "timer_queue.hpp"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+using namespace hal::driver;
+
+
+/*******************************************************************************
+ * PRIVATE METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+TimerNode* PairingTimerHeap::meld(TimerNode* a, TimerNode* b)
+{
+    if (a == nullptr) {
+        return b;
+    }
+    if (b == nullptr) {
+        return a;
+    }
+
+    if (b->deadline < a->deadline) {
+        swap(a, b);
+    }
+
+    /* b becomes the leftmost child of a */
+    b->prev = a;
+    b->next = a->child;
+    if (a->child != nullptr) {
+        a->child->prev = b;
+    }
+    a->child = b;
+    a->prev  = nullptr;
+    a->next  = nullptr;
+
+    return a;
+}
+
+TimerNode* PairingTimerHeap::mergePairs(TimerNode* first)
+{
+    TimerNode* pairs = nullptr;
+
+    /* First pass: meld siblings two by two from left to right, the results are
+     * stacked using their next hook */
+    while (first != nullptr) {
+        TimerNode* a = first;
+        TimerNode* b = a->next;
+
+        first   = (b != nullptr) ? b->next : nullptr;
+        a->prev = a->next = nullptr;
+        if (b != nullptr) {
+            b->prev = b->next = nullptr;
+        }
+
+        TimerNode* melded = meld(a, b);
+        melded->next      = pairs;
+        pairs             = melded;
+    }
+
+    /* Second pass: meld the pairs from right to left */
+    TimerNode* result = nullptr;
+    while (pairs != nullptr) {
+        TimerNode* next = pairs->next;
+        pairs->next     = nullptr;
+        result          = meld(result, pairs);
+        pairs           = next;
+    }
+
+    return result;
+}
+
+/*******************************************************************************
+ * PUBLIC METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+void SortedTimerList::insert(TimerNode& node)
+{
+    TimerNode* it = tail;
+
+    while (it != nullptr && it->deadline > node.deadline) { it = it->prev; }
+
+    /* Insert after it */
+    node.prev   = it;
+    node.next   = (it != nullptr) ? it->next : head;
+    node.child  = nullptr;
+    node.queued = true;
+    ++nb_nodes;
+    if (node.next != nullptr) {
+        node.next->prev = &node;
+    } else {
+        tail = &node;
+    }
+    if (it != nullptr) {
+        it->next = &node;
+    } else {
+        head = &node;
+    }
+}
+
+void SortedTimerList::remove(TimerNode& node)
+{
+    if (node.prev != nullptr) {
+        node.prev->next = node.next;
+    } else {
+        head = node.next;
+    }
+    if (node.next != nullptr) {
+        node.next->prev = node.prev;
+    } else {
+        tail = node.prev;
+    }
+
+    node.prev   = nullptr;
+    node.next   = nullptr;
+    node.queued = false;
+    --nb_nodes;
+}
+
+TimerNode* SortedTimerList::front() const
+{
+    return head;
+}
+
+size_t SortedTimerList::nearest(TimerNode** nodes, size_t max_nb_nodes) const
+{
+    size_t nb_found = 0;
+    TimerNode* it   = head;
+
+    while (it != nullptr && nb_found < max_nb_nodes) {
+        nodes[nb_found++] = it;
+        it                = it->next;
+    }
+
+    return nb_found;
+}
+
+void PairingTimerHeap::insert(TimerNode& node)
+{
+    node.prev   = nullptr;
+    node.next   = nullptr;
+    node.child  = nullptr;
+    node.queued = true;
+    ++nb_nodes;
+
+    root = meld(root, &node);
+}
+
+void PairingTimerHeap::remove(TimerNode& node)
+{
+    if (&node == root) {
+        root = mergePairs(node.child);
+    } else {
+        /* Detach the node from its parent's children */
+        if (node.prev->child == &node) {
+            node.prev->child = node.next;
+        } else {
+            node.prev->next = node.next;
+        }
+        if (node.next != nullptr) {
+            node.next->prev = node.prev;
+        }
+
+        root = meld(root, mergePairs(node.child));
+    }
+
+    node.prev   = nullptr;
+    node.next   = nullptr;
+    node.child  = nullptr;
+    node.queued = false;
+    --nb_nodes;
+}
+
+TimerNode* PairingTimerHeap::front() const
+{
+    return root;
+}
+
+size_t PairingTimerHeap::nearest(TimerNode** nodes, size_t max_nb_nodes) const
+{
+    if (root == nullptr || max_nb_nodes == 0) {
+        return 0;
+    }
+
+    size_t nb_found = 1;
+    nodes[0]        = root;
+
+    /* The parent of the next nearest node is one of the nodes found so far,
+     * its children are the only candidates */
+    while (nb_found < max_nb_nodes) {
+        TimerNode* best = nullptr;
+
+        for (size_t i = 0; i < nb_found; ++i) {
+            TimerNode* it = nodes[i]->child;
+            while (it != nullptr) {
+                if ((best == nullptr || it->deadline < best->deadline)
+                    && find(nodes, nodes + nb_found, it) == nodes + nb_found) {
+                    best = it;
+                }
+                it = it->next;
+            }
+        }
+
+        if (best == nullptr) {
+            break;
+        }
+        nodes[nb_found++] = best;
+    }
+
+    return nb_found;
+}
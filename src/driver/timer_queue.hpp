@@ -0,0 +1,114 @@
+
+/*******************************************************************************
+ * Priority queues of timer nodes ordered by deadline, used by the TimerDriver
+ * to keep track of pending wait operations. Nodes are intrusive: the queues
+ * never allocate memory, nodes are owned by the caller and only linked
+ * together by the queue.
+ ******************************************************************************/
+
+#ifndef _HAL_DRIVER_TIMER_QUEUE_HPP
+#define _HAL_DRIVER_TIMER_QUEUE_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+
+namespace hal
+{
+namespace driver
+{
+/*******************************************************************************
+ * TYPE DEFINITIONS
+ ******************************************************************************/
+
+struct TimerNode {
+    /* Absolute deadline, in timer ticks */
+    uint64_t deadline = 0;
+    bool queued       = false;
+
+    /* Hooks, their meaning depends on the queue holding the node */
+    TimerNode* prev  = nullptr;
+    TimerNode* next  = nullptr;
+    TimerNode* child = nullptr;
+};
+
+
+/*******************************************************************************
+ * CLASS DEFINITIONS
+ ******************************************************************************/
+
+class TimerQueue
+{
+  public:
+    virtual ~TimerQueue()
+    {
+    }
+
+    /** Add a node that is not queued yet */
+    virtual void insert(TimerNode& node) = 0;
+    /** Remove a queued node */
+    virtual void remove(TimerNode& node) = 0;
+    /** @return The node with the earliest deadline, nullptr if empty */
+    virtual TimerNode* front() const = 0;
+    /** Get the nodes with the earliest deadlines, in deadline order
+     * @param nodes
+     *  Filled with at most max_nb_nodes nodes
+     * @return The number of nodes written */
+    virtual size_t nearest(TimerNode** nodes, size_t max_nb_nodes) const = 0;
+
+    bool empty() const
+    {
+        return front() == nullptr;
+    }
+
+    size_t size() const
+    {
+        return nb_nodes;
+    }
+
+  protected:
+    size_t nb_nodes = 0;
+};
+
+/** A doubly linked list sorted by deadline. Insertion walks the list from its
+ * back, so it is O(1) when deadlines are mostly increasing and O(n) in the
+ * worst case. Removal is always O(1). Nodes with the same deadline are kept in
+ * insertion order. */
+class SortedTimerList : public TimerQueue
+{
+  public:
+    void insert(TimerNode& node) override;
+    void remove(TimerNode& node) override;
+    TimerNode* front() const override;
+    size_t nearest(TimerNode** nodes, size_t max_nb_nodes) const override;
+
+  private:
+    TimerNode* head = nullptr;
+    TimerNode* tail = nullptr;
+};
+
+/** A pairing heap: insertion is O(1) while removal of any node is O(log n)
+ * amortized. A node's prev hook points to its parent if it is the leftmost
+ * child, to its previous sibling otherwise. */
+class PairingTimerHeap : public TimerQueue
+{
+  public:
+    void insert(TimerNode& node) override;
+    void remove(TimerNode& node) override;
+    TimerNode* front() const override;
+    size_t nearest(TimerNode** nodes, size_t max_nb_nodes) const override;
+
+  private:
+    TimerNode* root = nullptr;
+
+    static TimerNode* meld(TimerNode* a, TimerNode* b);
+    static TimerNode* mergePairs(TimerNode* first);
+};
+
+}  // namespace driver
+}  // namespace hal
+
+#endif
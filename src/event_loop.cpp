@@ -16,6 +16,11 @@ using namespace device;
  * CONSTRUCTORS & DESTRUCTOR
  ******************************************************************************/
 
+EventLoop::EventLoop(OverflowPolicy overflow_policy)
+: nb_passed_over{}, overflow_policy{overflow_policy}, nb_dropped_events{0}
+{
+}
+
 /*******************************************************************************
  * OPERATOR IMPLEMENTATIONS
  ******************************************************************************/
@@ -24,6 +29,46 @@ using namespace device;
  * PRIVATE METHOD IMPLEMENTATIONS
  ******************************************************************************/
 
+bool EventLoop::empty() const
+{
+    for (auto& event_queue : event_queues) {
+        if (!event_queue.empty()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool EventLoop::popEvent(Event& event_handler)
+{
+    Priority selected = nb_priorities;
+
+    /* Select the highest non-empty level, unless a lower one is starving. In
+     * which case the lowest starving level wins as it waited the longest. */
+    for (Priority prio = highest_priority + 1; prio-- > lowest_priority;) {
+        if (event_queues[prio].empty()) {
+            nb_passed_over[prio] = 0;
+        } else if (selected == nb_priorities
+                   || nb_passed_over[prio] >= starvation_threshold) {
+            selected = prio;
+        }
+    }
+
+    if (selected == nb_priorities) {
+        return false;
+    }
+
+    for (Priority prio = lowest_priority; prio <= highest_priority; ++prio) {
+        if (prio != selected && !event_queues[prio].empty()) {
+            ++nb_passed_over[prio];
+        }
+    }
+    nb_passed_over[selected] = 0;
+
+    return event_queues[selected].pop(event_handler);
+}
+
 /*******************************************************************************
  * PROTECTED METHOD IMPLEMENTATIONS
  ******************************************************************************/
@@ -34,20 +79,53 @@ using namespace device;
 
 void EventLoop::run()
 {
-    while (true) {
-        while (event_queue.empty()) { __WFI(); }
+    Event event_handler;
+
+    enableIrqLatencyProbe();
 
-        /* Disable interrupts while accessing event_queue to avoid race
-         * conditions with interrupt handlers that may add events to the loop */
+    while (true) {
+        /* Interrupts are only masked while checking for new events: if an
+         * interrupt handler pushed an event between the check and WFI, we would
+         * sleep until the next interrupt. With interrupts masked, a pending
+         * interrupt still wakes the core up and its handler runs as soon as
+         * interrupts are enabled again. */
         disableInterrupts();
-        auto event_handler = event_queue.front();
-        event_queue.pop_front();
-        event_handler();
+        while (empty()) {
+            waitForInterrupt();
+            enableInterrupts();
+            disableInterrupts();
+        }
         enableInterrupts();
+
+        /* The queue is lock-free so handlers run with interrupts enabled and
+         * may be preempted by interrupt handlers pushing new events. */
+        popEvent(event_handler);
+        event_handler();
     }
 }
 
-void EventLoop::pushEvent(std::function<void()>&& event_handler)
+void EventLoop::pushEvent(Event&& event_handler, Priority prio)
+{
+    if (prio >= nb_priorities) {
+        throw InvalidEventPriorityException{prio};
+    }
+
+    if (event_queues[prio].push(move(event_handler))) {
+        return;
+    }
+
+    nb_dropped_events.fetch_add(1, memory_order_relaxed);
+    if (overflow_policy == OverflowPolicy::Throw) {
+        throw EventQueueOverflowException{};
+    }
+}
+
+void EventLoop::setOverflowPolicy(OverflowPolicy policy)
+{
+    overflow_policy = policy;
+}
+
+size_t EventLoop::getNbDroppedEvents() const
 {
-    event_queue.push_back(event_handler);
+    return nb_dropped_events.load(memory_order_relaxed);
 }
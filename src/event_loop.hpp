@@ -10,9 +10,37 @@
  * INCLUDE DIRECTIVES
  ******************************************************************************/
 
-#include <functional>
-#include <list>
+#include "event_queue.hpp"
+#include "executor.hpp"
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <string>
+
+
+/*******************************************************************************
+ * MACRO DEFINITION
+ ******************************************************************************/
+
+/* Maximum number of events waiting to be processed by the loop, must be a power
+ * of two. */
+#ifndef EVENT_QUEUE_SIZE
+    #define EVENT_QUEUE_SIZE 32
+#endif
+
+/* Number of priority levels, each level has its own queue of
+ * EVENT_QUEUE_SIZE events */
+#ifndef EVENT_LOOP_NB_PRIORITIES
+    #define EVENT_LOOP_NB_PRIORITIES 3
+#endif
+
+/* Number of times a pending event may be passed over by events of other
+ * levels before it is run regardless of its priority */
+#ifndef EVENT_LOOP_STARVATION_THRESHOLD
+    #define EVENT_LOOP_STARVATION_THRESHOLD 8
+#endif
 
 namespace hal
 {
@@ -20,14 +48,69 @@ namespace hal
  * CLASS DEFINITION
  ******************************************************************************/
 
-class EventLoop
+class EventLoop : public Executor
 {
   public:
+    /** What to do when an event is pushed while the queue is full */
+    enum class OverflowPolicy {
+        /* Raise an @ref EventQueueOverflowException */
+        Throw,
+        /* Discard the new event, see @ref getNbDroppedEvents */
+        Drop
+    };
+
+    /* Events of higher priority levels are always run first, unless an
+     * event of a lower level has been waiting for too long. */
+    static constexpr std::size_t queue_size    = EVENT_QUEUE_SIZE;
+    static constexpr unsigned nb_priorities    = EVENT_LOOP_NB_PRIORITIES;
+    static constexpr Priority lowest_priority  = 0;
+    static constexpr Priority highest_priority = nb_priorities - 1;
+    static constexpr Priority default_priority = nb_priorities / 2;
+    static constexpr unsigned starvation_threshold =
+        EVENT_LOOP_STARVATION_THRESHOLD;
+
+    static_assert(nb_priorities > 0, "EventLoop needs a priority level");
+
+    EventLoop(OverflowPolicy overflow_policy = OverflowPolicy::Throw);
+
     void run();
-    void pushEvent(std::function<void()>&& event_handler);
+    /** Add an event to the queue matching its priority. This is safe to call
+     * from any interrupt context and never allocates memory for the queue
+     * itself. */
+    void pushEvent(Event&& event_handler,
+                   Priority prio = default_priority) override;
+
+    void setOverflowPolicy(OverflowPolicy policy);
+    /** Number of events discarded because the queue was full */
+    std::size_t getNbDroppedEvents() const;
+
+  private:
+    std::array<EventQueue<Event, queue_size>, nb_priorities> event_queues;
+    /* Number of times the event at the front of each queue was passed over,
+     * only accessed by the loop itself */
+    std::array<unsigned, nb_priorities> nb_passed_over;
+    OverflowPolicy overflow_policy;
+    std::atomic<std::size_t> nb_dropped_events;
+
+    bool empty() const;
+    bool popEvent(Event& event_handler);
+};
+
+struct InvalidEventPriorityException : std::exception {
+    EventLoop::Priority prio;
+
+    InvalidEventPriorityException(EventLoop::Priority prio)
+    : prio{prio}, message{"Invalid event priority: " + std::to_string(prio)}
+    {
+    }
+
+    const char* what() const noexcept override
+    {
+        return message.c_str();
+    }
 
   private:
-    std::list<std::function<void()>> event_queue;
+    std::string message;
 };
 
 }  // namespace hal
@@ -0,0 +1,74 @@
+
+/*******************************************************************************
+ * A fixed-capacity, allocation-free queue of events. Any number of interrupt
+ * handlers may push events concurrently while a single consumer (the event
+ * loop) pops them. No locking is involved: each slot carries a sequence number
+ * telling producers and the consumer whether it is free or holds an event.
+ ******************************************************************************/
+
+#ifndef _HAL_EVENT_QUEUE_HPP
+#define _HAL_EVENT_QUEUE_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+
+namespace hal
+{
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+template<typename T, std::size_t N>
+class EventQueue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0,
+                  "EventQueue capacity must be a power of two");
+
+  public:
+    EventQueue();
+
+    /** Push an event at the back of the queue. This may be called from any
+     * interrupt context, including nested ones.
+     * @param event
+     *  The event to push, it is only moved from if the push succeeds.
+     * @return false if the queue is full */
+    bool push(T&& event);
+    /** Pop the event at the front of the queue. This must only ever be called
+     * from a single context (i.e. the event loop).
+     * @param event
+     *  Will receive the popped event
+     * @return false if the queue is empty */
+    bool pop(T& event);
+    /** Only meaningful when called by the consumer */
+    bool empty() const;
+
+    static constexpr std::size_t capacity()
+    {
+        return N;
+    }
+
+  private:
+    struct Slot {
+        /* seq == pos: the slot is free for the producer claiming pos
+         * seq == pos + 1: the slot holds the event pushed at pos */
+        std::atomic<std::size_t> seq;
+        T event;
+    };
+
+    std::array<Slot, N> slots;
+    std::atomic<std::size_t> push_pos;
+    /* Only accessed by the consumer */
+    std::size_t pop_pos;
+};
+
+}  // namespace hal
+
+#include "event_queue_impl.hpp"
+
+#endif
@@ -0,0 +1,91 @@
+
+/*******************************************************************************
+ * Implementation file for event queue templated functions
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "event_queue.hpp"
+
+#include <utility>
+
+
+/*******************************************************************************
+ * CONSTRUCTORS & DESTRUCTOR
+ ******************************************************************************/
+
+template<typename T, std::size_t N>
+hal::EventQueue<T, N>::EventQueue(): push_pos{0}, pop_pos{0}
+{
+    for (std::size_t i = 0; i < N; ++i) {
+        slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+}
+
+/*******************************************************************************
+ * PUBLIC METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+template<typename T, std::size_t N>
+bool hal::EventQueue<T, N>::push(T&& event)
+{
+    using namespace std;
+
+    size_t pos = push_pos.load(memory_order_relaxed);
+    Slot* slot;
+
+    /* Claim a slot. If an interrupt handler preempts us and pushes its own
+     * event in between, the CAS fails and we retry with the next position. */
+    while (true) {
+        slot         = &slots[pos & (N - 1)];
+        size_t seq   = slot->seq.load(memory_order_acquire);
+        ptrdiff_t df = static_cast<ptrdiff_t>(seq - pos);
+
+        if (df == 0) {
+            if (push_pos.compare_exchange_weak(pos, pos + 1,
+                                               memory_order_relaxed)) {
+                break;
+            }
+        } else if (df < 0) {
+            /* The consumer did not release this slot yet: queue is full */
+            return false;
+        } else {
+            pos = push_pos.load(memory_order_relaxed);
+        }
+    }
+
+    slot->event = move(event);
+    /* Publish the event to the consumer */
+    slot->seq.store(pos + 1, memory_order_release);
+
+    return true;
+}
+
+template<typename T, std::size_t N>
+bool hal::EventQueue<T, N>::pop(T& event)
+{
+    using namespace std;
+
+    Slot& slot = slots[pop_pos & (N - 1)];
+
+    if (slot.seq.load(memory_order_acquire) != pop_pos + 1) {
+        return false;
+    }
+
+    event      = move(slot.event);
+    slot.event = T{};
+    /* Hand the slot back to producers for the next lap */
+    slot.seq.store(pop_pos + N, memory_order_release);
+    ++pop_pos;
+
+    return true;
+}
+
+template<typename T, std::size_t N>
+bool hal::EventQueue<T, N>::empty() const
+{
+    return slots[pop_pos & (N - 1)].seq.load(std::memory_order_acquire)
+           != pop_pos + 1;
+}
@@ -0,0 +1,64 @@
+
+/*******************************************************************************
+ * Interface of the objects that run the events published by drivers. Drivers
+ * only know about this interface so their events may either be processed by
+ * the cooperative EventLoop or by a preemptive InterruptExecutor.
+ ******************************************************************************/
+
+#ifndef _HAL_EXECUTOR_HPP
+#define _HAL_EXECUTOR_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "inplace_function.hpp"
+
+#include <cstddef>
+#include <exception>
+
+
+namespace hal
+{
+/*******************************************************************************
+ * TYPE DEFINITIONS
+ ******************************************************************************/
+
+/** Maximum size of the state captured by callbacks given to drivers */
+constexpr std::size_t callback_capacity = 4 * sizeof(void*);
+/** An event must be able to hold a driver callback along with the arguments
+ * the driver binds to it */
+constexpr std::size_t event_capacity = callback_capacity + 8 * sizeof(void*);
+
+typedef InplaceFunction<void(), event_capacity> Event;
+
+
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+class Executor
+{
+  public:
+    /** Relative priority of an event among the events of a same executor */
+    typedef unsigned Priority;
+
+    virtual ~Executor()
+    {
+    }
+
+    /** Add an event to be run by this executor. This must be safe to call
+     * from any interrupt context. */
+    virtual void pushEvent(Event&& event_handler, Priority prio) = 0;
+};
+
+struct EventQueueOverflowException : std::exception {
+    const char* what() const noexcept override
+    {
+        return "Event queue overflow";
+    }
+};
+
+}  // namespace hal
+
+#endif
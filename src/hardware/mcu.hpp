@@ -7,8 +7,11 @@
 #ifndef _HAL_HARDWARE_MCU_H
 #define _HAL_HARDWARE_MCU_H
 
-#ifdef MCU_STM32F750
+#if defined(MCU_STM32F750)
     #include "stm32f750.hpp"
+#elif defined(MCU_HOST)
+    /* Simulated MCU of the host tests, found in test/host */
+    #include "host_mcu.hpp"
 #else
     #error "Undefined MCU"
 #endif
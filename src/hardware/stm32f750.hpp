@@ -24,8 +24,17 @@ constexpr unsigned nb_irqs = 113;
 
 /** CPU speed */
 constexpr unsigned core_clk_hz = 216000000;
+/** APB1 clock is not divided */
+constexpr unsigned apb1_clk_hz = core_clk_hz;
 /** APB2 clock is setup in boot sequence and is derived from the core clock. */
 constexpr unsigned apb2_clk_hz = core_clk_hz / 2;
+/** Timers are clocked at twice their APB clock when the latter is divided */
+constexpr unsigned apb1_timer_clk_hz =
+    (apb1_clk_hz == core_clk_hz) ? apb1_clk_hz : 2 * apb1_clk_hz;
+constexpr unsigned apb2_timer_clk_hz =
+    (apb2_clk_hz == core_clk_hz) ? apb2_clk_hz : 2 * apb2_clk_hz;
+/** Tick rate of the timers unless another one is requested */
+constexpr uint32_t default_timer_tick_hz = 1000000;
 
 /* The output clock of the PLL is given by:
  * VCO_out_clk = (VCO_in_clk / PLLM)*PLLN
@@ -40,6 +49,8 @@ constexpr unsigned pllq = 9;
 constexpr std::size_t nb_timers = 14;
 constexpr std::size_t nb_uarts  = 8;
 constexpr std::size_t nb_dmas   = 2;
+/** Number of IRQ lines reserved to be used as software interrupts */
+constexpr std::size_t nb_interrupt_executors = 4;
 
 constexpr uint32_t uart_baudrate = 115200;
 
@@ -0,0 +1,214 @@
+
+/*******************************************************************************
+ * A move-only replacement for std::function which stores the callable object
+ * inside a fixed-size buffer. It never allocates memory: trying to store a
+ * callable that does not fit in the buffer is a compilation error.
+ ******************************************************************************/
+
+#ifndef _HAL_INPLACE_FUNCTION_HPP
+#define _HAL_INPLACE_FUNCTION_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+namespace hal
+{
+/*******************************************************************************
+ * CONSTANT DEFINITIONS
+ ******************************************************************************/
+
+/** Default storage size, enough for a pointer to member function bound to an
+ * object or a lambda capturing a few pointers. */
+constexpr std::size_t inplace_function_default_capacity = 4 * sizeof(void*);
+
+
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+template<typename Signature,
+         std::size_t Capacity = inplace_function_default_capacity>
+class InplaceFunction;
+
+template<typename R, typename... Args, std::size_t Capacity>
+class InplaceFunction<R(Args...), Capacity>
+{
+    template<typename T>
+    struct IsInplaceFunction : std::false_type {
+    };
+
+    template<typename TSig, std::size_t TCapacity>
+    struct IsInplaceFunction<InplaceFunction<TSig, TCapacity>> :
+        std::true_type {
+    };
+
+    template<typename F, typename D = std::decay_t<F>>
+    using EnableIfCallable =
+        std::enable_if_t<!IsInplaceFunction<D>::value
+                         && std::is_invocable_r_v<R, D&, Args...>>;
+
+  public:
+    InplaceFunction() noexcept
+    {
+    }
+
+    InplaceFunction(std::nullptr_t) noexcept
+    {
+    }
+
+    /** Store a copy of the given callable object. Compilation will fail if the
+     * object does not fit inside the internal buffer. */
+    template<typename F, typename = EnableIfCallable<F>>
+    InplaceFunction(F&& f)
+    {
+        typedef std::decay_t<F> D;
+
+        static_assert(sizeof(D) <= Capacity,
+                      "Callable object is too large for InplaceFunction, "
+                      "reduce its captures or increase the capacity");
+        static_assert(alignof(D) <= alignof(Storage),
+                      "Callable object alignment is not supported");
+
+        ::new (&storage) D(std::forward<F>(f));
+        invoker = &invoke<D>;
+        manager = &manage<D>;
+    }
+
+    /** An InplaceFunction may be moved to another one with a larger storage
+     * without wrapping it. */
+    template<std::size_t OtherCapacity>
+    InplaceFunction(
+        InplaceFunction<R(Args...), OtherCapacity>&& other) noexcept
+    {
+        static_assert(OtherCapacity <= Capacity,
+                      "Cannot move InplaceFunction to a smaller one");
+        moveFrom(other);
+    }
+
+    InplaceFunction(InplaceFunction&& other) noexcept
+    {
+        moveFrom(other);
+    }
+
+    InplaceFunction(const InplaceFunction&) = delete;
+    InplaceFunction& operator=(const InplaceFunction&) = delete;
+
+    ~InplaceFunction()
+    {
+        reset();
+    }
+
+    InplaceFunction& operator=(InplaceFunction&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+
+        return *this;
+    }
+
+    template<std::size_t OtherCapacity>
+    InplaceFunction&
+        operator=(InplaceFunction<R(Args...), OtherCapacity>&& other) noexcept
+    {
+        static_assert(OtherCapacity <= Capacity,
+                      "Cannot move InplaceFunction to a smaller one");
+        reset();
+        moveFrom(other);
+
+        return *this;
+    }
+
+    InplaceFunction& operator=(std::nullptr_t) noexcept
+    {
+        reset();
+
+        return *this;
+    }
+
+    template<typename F, typename = EnableIfCallable<F>>
+    InplaceFunction& operator=(F&& f)
+    {
+        return *this = InplaceFunction{std::forward<F>(f)};
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return invoker != nullptr;
+    }
+
+    /** Call the stored object. Just like std::function, std::bad_function_call
+     * is raised if this is empty. */
+    R operator()(Args... args) const
+    {
+        if (invoker == nullptr) {
+            throw std::bad_function_call{};
+        }
+
+        return invoker(&storage, std::forward<Args>(args)...);
+    }
+
+  private:
+    template<typename TSig, std::size_t TCapacity>
+    friend class InplaceFunction;
+
+    typedef R (*Invoker)(void* obj, Args&&... args);
+    /* Move-constructs obj into dst if dst is not null, then destroys obj */
+    typedef void (*Manager)(void* obj, void* dst);
+    typedef std::aligned_storage_t<Capacity, alignof(std::max_align_t)> Storage;
+
+    mutable Storage storage;
+    Invoker invoker = nullptr;
+    Manager manager = nullptr;
+
+    template<typename D>
+    static R invoke(void* obj, Args&&... args)
+    {
+        return std::invoke(*static_cast<D*>(obj), std::forward<Args>(args)...);
+    }
+
+    template<typename D>
+    static void manage(void* obj, void* dst)
+    {
+        D* d = static_cast<D*>(obj);
+
+        if (dst != nullptr) {
+            ::new (dst) D(std::move(*d));
+        }
+        d->~D();
+    }
+
+    template<std::size_t OtherCapacity>
+    void moveFrom(InplaceFunction<R(Args...), OtherCapacity>& other) noexcept
+    {
+        if (other.manager != nullptr) {
+            other.manager(&other.storage, &storage);
+        }
+        invoker       = other.invoker;
+        manager       = other.manager;
+        other.invoker = nullptr;
+        other.manager = nullptr;
+    }
+
+    void reset() noexcept
+    {
+        if (manager != nullptr) {
+            manager(&storage, nullptr);
+        }
+        invoker = nullptr;
+        manager = nullptr;
+    }
+};
+
+}  // namespace hal
+
+#endif
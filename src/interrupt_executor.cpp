@@ -0,0 +1,81 @@
+
+/*******************************************************************************
+ * Implementation file of the InterruptExecutor class
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "interrupt_executor.hpp"
+
+#include "hardware/mcu.hpp"
+
+using namespace std;
+using namespace hal;
+
+/*******************************************************************************
+ * CONSTRUCTORS & DESTRUCTOR
+ ******************************************************************************/
+
+InterruptExecutor::InterruptExecutor(IRQn_Type irq_nb, uint32_t nvic_priority)
+: irq_nb{irq_nb}
+{
+    NVIC_SetPriority(irq_nb, nvic_priority);
+    NVIC_ClearPendingIRQ(irq_nb);
+    NVIC_EnableIRQ(irq_nb);
+}
+
+InterruptExecutor::~InterruptExecutor()
+{
+    NVIC_DisableIRQ(irq_nb);
+}
+
+/*******************************************************************************
+ * OPERATOR IMPLEMENTATIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PRIVATE METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PROTECTED METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+/*******************************************************************************
+ * PUBLIC METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+void InterruptExecutor::pushEvent(Event&& event_handler, Priority prio)
+{
+    if (!event_queue.push(move(event_handler))) {
+        throw EventQueueOverflowException{};
+    }
+
+    /* If the line has a higher priority than the caller, the handler runs
+     * right after this returns */
+    NVIC_SetPendingIRQ(irq_nb);
+}
+
+void InterruptExecutor::setNvicPriority(uint32_t nvic_priority)
+{
+    NVIC_SetPriority(irq_nb, nvic_priority);
+}
+
+uint32_t InterruptExecutor::getNvicPriority() const
+{
+    return NVIC_GetPriority(irq_nb);
+}
+
+void InterruptExecutor::onSoftwareInterrupt()
+{
+    Event event_handler;
+
+    /* Events pushed while running a handler are picked up by this same loop,
+     * the IRQ may then be pending again for nothing which is harmless. */
+    while (event_queue.pop(event_handler)) {
+        event_handler();
+    }
+    event_handler = nullptr;
+}
@@ -0,0 +1,62 @@
+
+/*******************************************************************************
+ * An executor running its events from an otherwise unused NVIC IRQ line that is
+ * triggered by software. Events pushed to it preempt the EventLoop as well as
+ * the handlers of any executor with a lower NVIC priority, and are themselves
+ * preempted by higher priority interrupts.
+ ******************************************************************************/
+
+#ifndef _HAL_INTERRUPT_EXECUTOR_HPP
+#define _HAL_INTERRUPT_EXECUTOR_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "event_loop.hpp"
+#include "event_queue.hpp"
+#include "executor.hpp"
+#include "hardware/mcu.hpp"
+
+#include <cstdint>
+
+
+namespace hal
+{
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+class InterruptExecutor : public Executor
+{
+  public:
+    static constexpr std::size_t queue_size = EVENT_QUEUE_SIZE;
+
+    /** @param irq_nb
+     *  The IRQ line used as software interrupt, the matching vtable entry must
+     * call @ref onSoftwareInterrupt
+     * @param nvic_priority
+     *  NVIC priority of the line, lower values preempt higher ones */
+    InterruptExecutor(IRQn_Type irq_nb, uint32_t nvic_priority);
+    ~InterruptExecutor();
+
+    /** Add an event to the queue and pend the IRQ line. All events of an
+     * executor run at its NVIC priority so prio is ignored: use several
+     * executors to get several preemption levels. */
+    void pushEvent(Event&& event_handler, Priority prio = 0) override;
+
+    void setNvicPriority(uint32_t nvic_priority);
+    uint32_t getNvicPriority() const;
+
+    /** Run every pending event, to be called by the IRQ handler only */
+    void onSoftwareInterrupt();
+
+  private:
+    IRQn_Type irq_nb;
+    /* The IRQ handler cannot preempt itself so it is the single consumer */
+    EventQueue<Event, queue_size> event_queue;
+};
+
+}  // namespace hal
+
+#endif
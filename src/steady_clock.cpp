@@ -0,0 +1,53 @@
+
+/*******************************************************************************
+ * Implementation file of the SteadyClock class
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "steady_clock.hpp"
+
+using namespace std;
+using namespace hal;
+
+
+/*******************************************************************************
+ * STATIC VARIABLE DEFINITIONS
+ ******************************************************************************/
+
+device::TimerDevice* SteadyClock::source = nullptr;
+device::TimerDevice::TickRate SteadyClock::tick_rate{1000000, 1};
+uint64_t SteadyClock::ns_per_tick = 0;
+
+
+/*******************************************************************************
+ * PUBLIC METHOD IMPLEMENTATIONS
+ ******************************************************************************/
+
+void SteadyClock::setSource(device::TimerDevice& timer)
+{
+    timer.startFreeRunning();
+    tick_rate = timer.getTickRate();
+
+    uint64_t ns_per_clk_div = 1000000000ULL * tick_rate.divider;
+    ns_per_tick             = (ns_per_clk_div % tick_rate.clk_hz == 0)
+                                  ? ns_per_clk_div / tick_rate.clk_hz
+                                  : 0;
+    source = &timer;
+}
+
+SteadyClock::time_point SteadyClock::now()
+{
+    if (source == nullptr) {
+        throw SteadyClockNotStartedException{};
+    }
+
+    /* The device takes care of overflows happening while it is read */
+    uint64_t ticks = source->getCounter();
+    uint64_t ns    = (ns_per_tick != 0) ? ticks * ns_per_tick
+                                        : tick_rate.toNanoseconds(ticks);
+
+    return time_point{duration{static_cast<rep>(ns)}};
+}
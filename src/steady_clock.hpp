@@ -0,0 +1,70 @@
+
+/*******************************************************************************
+ * A monotonic clock meeting the std::chrono Clock requirements. It reads the
+ * free-running counter of a timer device, extended to 64 bits by the device,
+ * so it never wraps around in practice. The source device is chosen at run
+ * time: usually a 32-bit timer such as TIM2 or TIM5 on target, and a fake
+ * device on host. Its ticks are converted to ns whatever its tick rate.
+ ******************************************************************************/
+
+#ifndef _HAL_STEADY_CLOCK_HPP
+#define _HAL_STEADY_CLOCK_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "device/timer_device.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+
+
+namespace hal
+{
+/*******************************************************************************
+ * CLASS DEFINITIONS
+ ******************************************************************************/
+
+class SteadyClock
+{
+  public:
+    typedef int64_t rep;
+    /** Readings are in ns, whatever the tick rate of the source device: 1 µs
+     * ticks by default, or down to the timer clock period when prescaling is
+     * disabled */
+    typedef std::nano period;
+    typedef std::chrono::duration<rep, period> duration;
+    typedef std::chrono::time_point<SteadyClock> time_point;
+
+    static constexpr bool is_steady = true;
+
+    /** Start the free-running counter of the given device and read the time
+     * from it from now on. The device may still be shared with a TimerDriver
+     * in FreeRunning mode. Time starts at 0 when the counter is started.
+     * @throw UnsupportedDeviceOperation if the device has no free-running
+     * counter */
+    static void setSource(device::TimerDevice& timer);
+
+    /** Lock-free and safe to call from any interrupt context
+     * @throw SteadyClockNotStartedException if no source was set */
+    static time_point now();
+
+  private:
+    static device::TimerDevice* source;
+    static device::TimerDevice::TickRate tick_rate;
+    /* Set when a tick lasts a whole number of ns, which spares divisions */
+    static uint64_t ns_per_tick;
+};
+
+struct SteadyClockNotStartedException : std::exception {
+    const char* what() const noexcept override
+    {
+        return "No source was set for the steady clock";
+    }
+};
+
+}  // namespace hal
+
+#endif
@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * Minimal assertion helpers shared by the host tests. A failed check is
+ * reported and counted but does not stop the test, whose exit code tells
+ * whether every check passed.
+ ******************************************************************************/
+
+#ifndef _HAL_TEST_CHECK_HPP
+#define _HAL_TEST_CHECK_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include <chrono>
+#include <cstdio>
+
+
+/*******************************************************************************
+ * MACRO DEFINITION
+ ******************************************************************************/
+
+#define CHECK(cond) host_test::check((cond), #cond, __FILE__, __LINE__)
+
+
+namespace host_test
+{
+/*******************************************************************************
+ * FUNCTION DEFINITIONS
+ ******************************************************************************/
+
+inline unsigned nb_failures = 0;
+
+inline bool check(bool ok, const char* expr, const char* file, int line)
+{
+    if (!ok) {
+        ++nb_failures;
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+    }
+
+    return ok;
+}
+
+/** To be returned from main */
+inline int report(const char* test_name)
+{
+    std::printf("%s: %s\n", test_name, nb_failures ? "FAILED" : "passed");
+
+    return nb_failures ? 1 : 0;
+}
+
+/** Wall-clock time taken by f(), in nanoseconds */
+template<typename F>
+double measureNs(F&& f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    return elapsed.count();
+}
+
+}  // namespace host_test
+
+#endif
@@ -0,0 +1,205 @@
+/*******************************************************************************
+ * Host test of the coroutine awaitables of the CharacterDriver & TimerDriver,
+ * on simulated devices. Coroutines must only be resumed by the executor of the
+ * awaited driver, and their frames must go back to the pool once they return.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "check.hpp"
+#include "sim_character_device.hpp"
+#include "sim_executor.hpp"
+#include "sim_timer_device.hpp"
+
+#include <chrono>
+#include <coroutine.hpp>
+#include <driver/character_driver.hpp>
+#include <driver/timer_driver.hpp>
+#include <span>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono_literals;
+using namespace hal;
+using namespace hal::device;
+using namespace hal::driver;
+using namespace host_test;
+
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS
+ ******************************************************************************/
+
+namespace
+{
+typedef CharacterDriver<char> Uart;
+
+/* Reads a line, writes it back then waits a bit before greeting */
+Task echo(Uart& uart, TimerDriver& timer, vector<string>& trace)
+{
+    char line[16];
+
+    auto [nb_read, read_status] = co_await uart.read(span{line}, '\n');
+    trace.push_back("read " + string(line, nb_read));
+
+    auto [nb_written, write_status] =
+        co_await uart.write(span<const char>{line, nb_read});
+    trace.push_back("wrote " + to_string(nb_written));
+
+    ErrorStatus sleep_status = co_await timer.sleep(10ms);
+    trace.push_back(sleep_status ? "sleep failed" : "slept");
+
+    static const char bye[] = "bye";
+    Uart::IoVec iov[]       = {{"good", 4}, {bye, 3}};
+    auto [nb_writtenv, writev_status] = co_await uart.writev(span{iov});
+    trace.push_back("wrote " + to_string(nb_writtenv));
+}
+
+Task sleepForever(TimerDriver& timer)
+{
+    co_await timer.sleep(1h);
+}
+
+Task writeOnce(Uart& uart, Uart::IoResult& result)
+{
+    static const char msg[] = "msg";
+    result = co_await uart.write(span<const char>{msg, 3});
+}
+
+Task readOnce(Uart& uart, Uart::IoResult& result)
+{
+    char buf[4];
+    result = co_await uart.read(span{buf});
+}
+
+Task sleepOnce(TimerDriver& timer, ErrorStatus& status)
+{
+    status = co_await timer.sleep(1ms);
+}
+
+void testEcho()
+{
+    SimExecutor executor;
+    SimCharacterDevice uart_device;
+    SimTimerDevice timer_device;
+    Uart uart{executor, uart_device};
+    TimerDriver timer{executor, timer_device};
+    vector<string> trace;
+
+    size_t nb_free_frames = CoroutineFramePool::getNbFreeFrames();
+
+    echo(uart, timer, trace);
+    CHECK(CoroutineFramePool::getNbFreeFrames() == nb_free_frames - 1);
+    CHECK(uart_device.isReading());
+
+    uart_device.receive("hi\n");
+    /* Resumed by the executor only */
+    CHECK(trace.empty());
+    executor.runAll();
+    CHECK(trace == (vector<string>{"read hi\n"}));
+    CHECK(uart_device.isWriting());
+
+    uart_device.completeWrite();
+    executor.runAll();
+    CHECK(uart_device.output == "hi\n");
+    CHECK(trace.back() == "wrote 3");
+
+    /* 1 tick per µs */
+    uint64_t slept_at = timer_device.getTime();
+    timer_device.advance(9999);
+    executor.runAll();
+    CHECK(trace.size() == 2);
+    CHECK(timer_device.advanceToNextExpiry());
+    executor.runAll();
+    CHECK(timer_device.getTime() - slept_at == 10000);
+    CHECK(trace.back() == "slept");
+
+    uart_device.completeWrite();
+    executor.runAll();
+    uart_device.completeWrite();
+    executor.runAll();
+    CHECK(uart_device.output == "hi\ngoodbye");
+    CHECK(trace.back() == "wrote 7");
+
+    CHECK(CoroutineFramePool::getNbFreeFrames() == nb_free_frames);
+}
+
+void testFramePoolExhaustion()
+{
+    SimExecutor executor;
+    SimTimerDevice timer_device;
+    TimerDriver timer{executor, timer_device};
+    size_t nb_free_frames = CoroutineFramePool::getNbFreeFrames();
+
+    for (size_t i = 0; i < nb_free_frames; ++i) {
+        sleepForever(timer);
+    }
+    CHECK(CoroutineFramePool::getNbFreeFrames() == 0);
+
+    bool thrown = false;
+    try {
+        sleepForever(timer);
+    } catch (CoroutineFrameAllocFailure&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+
+    /* Frames are released as the coroutines return */
+    CHECK(timer_device.advanceToNextExpiry());
+    executor.runAll();
+    CHECK(CoroutineFramePool::getNbFreeFrames() == nb_free_frames);
+}
+
+/* Operations that cannot start resume the coroutine at once with a failure,
+ * rather than raising an exception that would terminate */
+void testStartFailures()
+{
+    SimExecutor executor;
+    SimCharacterDevice uart_device;
+    SimTimerDevice timer_device;
+    Uart uart{executor, uart_device, 0, Uart::OverflowPolicy::Throw};
+    TimerDriver timer{executor, timer_device};
+    Uart::IoResult result{1, ErrorCode::Success};
+    size_t nb_free_frames = CoroutineFramePool::getNbFreeFrames();
+
+    /* The running write, then a full queue */
+    for (size_t i = 0; i <= Uart::write_queue_size; ++i) {
+        uart.asyncWrite("x", 1);
+    }
+    writeOnce(uart, result);
+    CHECK(result.nb_elem == 0);
+    CHECK(result.status.get_code() == ErrorCode::Failure);
+
+    /* A read is already running */
+    uart.asyncRead(nullptr, 0);
+    result = Uart::IoResult{1, ErrorCode::Success};
+    readOnce(uart, result);
+    CHECK(result.nb_elem == 0);
+    CHECK(result.status.get_code() == ErrorCode::Failure);
+
+    ErrorStatus status{ErrorCode::Success};
+    timer_device.fail_suspend = true;
+    sleepOnce(timer, status);
+    CHECK(status.get_code() == ErrorCode::Failure);
+
+    CHECK(CoroutineFramePool::getNbFreeFrames() == nb_free_frames);
+}
+
+}  // namespace
+
+
+/*******************************************************************************
+ * MAIN
+ ******************************************************************************/
+
+int main()
+{
+    testEcho();
+    testFramePoolExhaustion();
+    testStartFailures();
+
+    return host_test::report("coroutine_test");
+}
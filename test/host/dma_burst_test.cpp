@@ -0,0 +1,202 @@
+/*******************************************************************************
+ * Host model test of the burst selection of the STM32F750 DMA. Transfers are
+ * cut into the AHB transactions a port would issue, for every alignment, data
+ * width and size up to a few KB: bursts must never cross a 1 KB boundary, must
+ * fit and divide the FIFO threshold and must not overrun the transfer, and no
+ * longer burst may be allowed. Bandwidth figures need the target hardware, only
+ * the number of AHB transactions is reported here.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "check.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <device/stm32f750/stm32f750_dma_burst.hpp>
+
+using namespace std;
+using namespace hal::device;
+
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS
+ ******************************************************************************/
+
+namespace
+{
+typedef DmaDevice::DataWidth DataWidth;
+
+constexpr DataWidth data_widths[] = {DataWidth::Byte, DataWidth::HalfWord,
+                                     DataWidth::Word};
+
+/* Checks every transaction of a port issuing bursts of the given length.
+ * @return The number of transactions */
+size_t checkTransactions(uintptr_t addr,
+                         DataWidth data_width,
+                         size_t count,
+                         unsigned nb_beats,
+                         bool& valid)
+{
+    size_t burst_size      = nb_beats * static_cast<size_t>(data_width);
+    size_t nb_transactions = 0;
+
+    valid &= (burst_size <= stm32f750_dma_fifo_size);
+    valid &= (stm32f750_dma_fifo_size % burst_size == 0);
+    valid &= (count % burst_size == 0);
+
+    for (size_t offset = 0; offset < count; offset += burst_size) {
+        uintptr_t first = addr + offset;
+        uintptr_t last  = first + burst_size - 1;
+
+        valid &= (first / ahb_burst_boundary == last / ahb_burst_boundary);
+        ++nb_transactions;
+    }
+
+    return nb_transactions;
+}
+
+/* No longer burst than the selected one meets the constraints */
+bool isLongest(uintptr_t addr,
+               DataWidth data_width,
+               size_t count,
+               unsigned nb_beats)
+{
+    for (unsigned longer : {4U, 8U, 16U}) {
+        size_t burst_size = longer * static_cast<size_t>(data_width);
+
+        if (longer > nb_beats && burst_size <= stm32f750_dma_fifo_size
+            && addr % burst_size == 0 && count % burst_size == 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Every alignment within 2 KB, so that bursts start right before, on and
+ * after two 1 KB boundaries. The selection only depends on the size modulo
+ * the FIFO size, which every size up to 128 bytes covers, longer transfers
+ * then span the boundaries. */
+void testAllLayouts()
+{
+    size_t nb_layouts = 0;
+    bool valid        = true;
+    bool longest      = true;
+
+    for (DataWidth data_width : data_widths) {
+        size_t width = static_cast<size_t>(data_width);
+
+        for (uintptr_t addr = 0x20010000 - 1024; addr < 0x20010000 + 1024;
+             addr += width) {
+            for (size_t count = width; count <= 128 + 3 * 1024;
+                 count += (count < 128) ? width : 1024) {
+                unsigned nb_beats = selectStm32f750DmaBurstLength(
+                    addr, data_width, true, count);
+
+                checkTransactions(addr, data_width, count, nb_beats, valid);
+                longest &= isLongest(addr, data_width, count, nb_beats);
+                ++nb_layouts;
+            }
+        }
+    }
+
+    CHECK(valid);
+    CHECK(longest);
+    printf("%zu transfer layouts checked\n", nb_layouts);
+}
+
+/* A fixed address, such as a peripheral register, is always accessed one item
+ * at a time */
+void testFixedAddress()
+{
+    for (DataWidth data_width : data_widths) {
+        CHECK(selectStm32f750DmaBurstLength(0x40011028, data_width, false,
+                                            1024)
+              == 1);
+    }
+}
+
+/* Both buffers of a double-buffered transfer use the shorter of their bursts,
+ * which must be valid for each of them */
+void testDoubleBuffer()
+{
+    bool valid = true;
+
+    for (uintptr_t addr0 = 0x20010000; addr0 < 0x20010000 + 64; addr0 += 4) {
+        for (uintptr_t addr1 = 0x20020000 - 32; addr1 < 0x20020000 + 32;
+             addr1 += 4) {
+            for (size_t count : {16, 64, 96, 1024}) {
+                unsigned nb_beats = min(
+                    selectStm32f750DmaBurstLength(addr0, DataWidth::Word,
+                                                  true, count),
+                    selectStm32f750DmaBurstLength(addr1, DataWidth::Word,
+                                                  true, count));
+
+                checkTransactions(addr0, DataWidth::Word, count, nb_beats,
+                                  valid);
+                checkTransactions(addr1, DataWidth::Word, count, nb_beats,
+                                  valid);
+            }
+        }
+    }
+
+    CHECK(valid);
+}
+
+/* Memory to memory copies of 4 KB: both ports burst */
+void printCopyTransactions()
+{
+    struct Copy {
+        const char* name;
+        uintptr_t src;
+        uintptr_t dst;
+        DataWidth data_width;
+    };
+    static const Copy copies[] = {
+        {"16-byte aligned words", 0x20010000, 0x20020000, DataWidth::Word},
+        {"8-byte aligned words", 0x20010008, 0x20020000, DataWidth::Word},
+        {"4-byte aligned words", 0x20010004, 0x20020000, DataWidth::Word},
+        {"16-byte aligned bytes", 0x20010000, 0x20020000, DataWidth::Byte},
+        {"unaligned bytes", 0x20010001, 0x20020000, DataWidth::Byte},
+    };
+    constexpr size_t count = 4096;
+
+    for (const Copy& copy : copies) {
+        bool valid    = true;
+        size_t single = count / static_cast<size_t>(copy.data_width);
+        size_t nb_transactions =
+            checkTransactions(copy.src, copy.data_width, count,
+                              selectStm32f750DmaBurstLength(
+                                  copy.src, copy.data_width, true, count),
+                              valid)
+            + checkTransactions(copy.dst, copy.data_width, count,
+                                selectStm32f750DmaBurstLength(
+                                    copy.dst, copy.data_width, true, count),
+                                valid);
+
+        CHECK(valid);
+        printf("4 KB copy, %-22s: %5zu AHB transactions, %5zu single beats\n",
+               copy.name, nb_transactions, 2 * single);
+    }
+}
+
+}  // namespace
+
+
+/*******************************************************************************
+ * MAIN
+ ******************************************************************************/
+
+int main()
+{
+    testAllLayouts();
+    testFixedAddress();
+    testDoubleBuffer();
+    printCopyTransactions();
+
+    return host_test::report("dma_burst_test");
+}
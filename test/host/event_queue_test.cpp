@@ -0,0 +1,267 @@
+/*******************************************************************************
+ * Host test of the lock-free event queue. Threads stand for interrupt handlers
+ * pushing events concurrently while the main thread consumes them, and the
+ * throughput is compared with the std::list of std::function the EventLoop
+ * used before, guarded by a mutex as interrupt masking would.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "check.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <event_loop.hpp>
+#include <event_queue.hpp>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace hal;
+
+
+/*******************************************************************************
+ * PRIVATE TYPE DEFINITIONS
+ ******************************************************************************/
+
+namespace
+{
+constexpr unsigned nb_producers           = 4;
+constexpr unsigned nb_events_per_producer = 500000;
+constexpr unsigned nb_events = nb_producers * nb_events_per_producer;
+
+/* Records the events run by the consumer, per producer */
+struct Tally {
+    vector<unsigned> nb_run = vector<unsigned>(nb_producers, 0);
+    unsigned nb_out_of_order = 0;
+
+    void onEvent(unsigned producer, unsigned seq)
+    {
+        if (seq != nb_run[producer]) {
+            ++nb_out_of_order;
+        }
+        nb_run[producer] = seq + 1;
+    }
+};
+
+/* The EventLoop queue before it became a ring: pushing was only safe with
+ * interrupts masked, which a mutex stands for on the host */
+class ListQueue
+{
+  public:
+    bool push(function<void()>&& event)
+    {
+        lock_guard<mutex> lock{queue_mutex};
+        events.push_back(move(event));
+        return true;
+    }
+
+    bool pop(function<void()>& event)
+    {
+        lock_guard<mutex> lock{queue_mutex};
+        if (events.empty()) {
+            return false;
+        }
+        event = move(events.front());
+        events.pop_front();
+        return true;
+    }
+
+  private:
+    mutex queue_mutex;
+    list<function<void()>> events;
+};
+
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS
+ ******************************************************************************/
+
+/* Push every event from nb_producers threads and run them from this one.
+ * Returns the number of events run per second. */
+template<typename Queue, typename EventType>
+double runContended(Queue& queue, Tally& tally)
+{
+    vector<thread> producers;
+    atomic<bool> go{false};
+    unsigned nb_run = 0;
+
+    double elapsed_ns = host_test::measureNs([&] {
+        for (unsigned producer = 0; producer < nb_producers; ++producer) {
+            producers.emplace_back([&, producer] {
+                while (!go.load()) { this_thread::yield(); }
+
+                for (unsigned seq = 0; seq < nb_events_per_producer; ++seq) {
+                    EventType event{[&tally, producer, seq] {
+                        tally.onEvent(producer, seq);
+                    }};
+
+                    /* A full queue is reported to the handler, which would
+                     * drop the event: retry instead to count every one */
+                    while (!queue.push(move(event))) { this_thread::yield(); }
+                }
+            });
+        }
+
+        go.store(true);
+
+        EventType event;
+        while (nb_run < nb_events) {
+            if (queue.pop(event)) {
+                event();
+                ++nb_run;
+            } else {
+                this_thread::yield();
+            }
+        }
+
+        for (auto& producer : producers) {
+            producer.join();
+        }
+    });
+
+    return nb_events / (elapsed_ns * 1e-9);
+}
+
+/* Push and pop from a single context, without any contention */
+template<typename Queue, typename EventType>
+double runUncontended(Queue& queue)
+{
+    constexpr unsigned batch = 16;
+    unsigned nb_run          = 0;
+
+    double elapsed_ns = host_test::measureNs([&] {
+        EventType event;
+
+        for (unsigned i = 0; i < nb_events; i += batch) {
+            for (unsigned j = 0; j < batch; ++j) {
+                queue.push(EventType{[&nb_run] { ++nb_run; }});
+            }
+            while (queue.pop(event)) { event(); }
+        }
+    });
+
+    CHECK(nb_run == nb_events);
+
+    return nb_events / (elapsed_ns * 1e-9);
+}
+
+void testFifoOrder()
+{
+    EventQueue<unsigned, 8> queue;
+    unsigned value;
+
+    CHECK(queue.empty());
+    CHECK(!queue.pop(value));
+
+    /* Several laps so that sequence numbers wrap the ring */
+    for (unsigned lap = 0; lap < 5; ++lap) {
+        for (unsigned i = 0; i < 8; ++i) {
+            unsigned pushed = lap * 8 + i;
+            CHECK(queue.push(move(pushed)));
+        }
+
+        unsigned extra = 0;
+        CHECK(!queue.push(move(extra)));
+
+        for (unsigned i = 0; i < 8; ++i) {
+            CHECK(queue.pop(value) && value == lap * 8 + i);
+        }
+        CHECK(queue.empty());
+    }
+}
+
+void testOverflowPolicy()
+{
+    EventLoop loop{EventLoop::OverflowPolicy::Throw};
+    bool thrown = false;
+
+    try {
+        for (unsigned i = 0; i <= EventLoop::queue_size; ++i) {
+            loop.pushEvent([] {});
+        }
+    } catch (EventQueueOverflowException&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(loop.getNbDroppedEvents() == 1);
+
+    loop.setOverflowPolicy(EventLoop::OverflowPolicy::Drop);
+    loop.pushEvent([] {});
+    CHECK(loop.getNbDroppedEvents() == 2);
+}
+
+void testInvalidPriority()
+{
+    EventLoop loop;
+    string message;
+
+    try {
+        loop.pushEvent([] {}, EventLoop::nb_priorities);
+    } catch (InvalidEventPriorityException& e) {
+        message = e.what();
+    }
+    CHECK(message
+          == "Invalid event priority: "
+                 + to_string(EventLoop::nb_priorities));
+}
+
+void testContended()
+{
+    Tally ring_tally;
+    Tally list_tally;
+    EventQueue<Event, 1024> ring;
+    ListQueue list;
+
+    double ring_rate = runContended<decltype(ring), Event>(ring, ring_tally);
+    double list_rate =
+        runContended<ListQueue, function<void()>>(list, list_tally);
+
+    for (unsigned producer = 0; producer < nb_producers; ++producer) {
+        CHECK(ring_tally.nb_run[producer] == nb_events_per_producer);
+        CHECK(list_tally.nb_run[producer] == nb_events_per_producer);
+    }
+    /* Each producer's events must come out in the order it pushed them */
+    CHECK(ring_tally.nb_out_of_order == 0);
+    CHECK(list_tally.nb_out_of_order == 0);
+
+    printf("%u events from %u producers: ring %.2f M/s, std::list %.2f M/s\n",
+           nb_events, nb_producers, ring_rate * 1e-6, list_rate * 1e-6);
+}
+
+void testUncontended()
+{
+    EventQueue<Event, 1024> ring;
+    ListQueue list;
+
+    double ring_rate = runUncontended<decltype(ring), Event>(ring);
+    double list_rate = runUncontended<ListQueue, function<void()>>(list);
+
+    printf("%u events from a single context: ring %.2f M/s, "
+           "std::list %.2f M/s\n",
+           nb_events, ring_rate * 1e-6, list_rate * 1e-6);
+}
+
+}  // namespace
+
+
+/*******************************************************************************
+ * MAIN
+ ******************************************************************************/
+
+int main()
+{
+    testFifoOrder();
+    testOverflowPolicy();
+    testInvalidPriority();
+    testContended();
+    testUncontended();
+
+    return host_test::report("event_queue_test");
+}
@@ -0,0 +1,184 @@
+/*******************************************************************************
+ * Implementation file of the simulated MCU
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "host_mcu.hpp"
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <device/irqs.hpp>
+#include <limits>
+#include <vector>
+
+using namespace std;
+using namespace hal::device;
+
+
+/*******************************************************************************
+ * PRIVATE VARIABLES
+ ******************************************************************************/
+
+namespace
+{
+struct IrqLine {
+    uint32_t priority = 0;
+    bool enabled      = false;
+    bool pending      = false;
+};
+
+uint32_t primask = 0;
+array<IrqLine, nb_host_irq_lines> lines;
+/* Lines whose handler runs or was preempted, innermost last */
+vector<int> active_irqs;
+
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS
+ ******************************************************************************/
+
+uint32_t getExecutionPriority()
+{
+    return active_irqs.empty() ? numeric_limits<uint32_t>::max()
+                               : lines[active_irqs.back()].priority;
+}
+
+/* Run the handlers of every line allowed to preempt the current context, the
+ * most urgent first. On equal priorities the lowest line number wins. */
+void takePendingIrqs()
+{
+    while (primask == 0) {
+        int selected = -1;
+
+        for (unsigned irq = 0; irq < nb_host_irq_lines; ++irq) {
+            const IrqLine& line = lines[irq];
+
+            if (line.enabled && line.pending
+                && line.priority < getExecutionPriority()
+                && (selected < 0 || line.priority < lines[selected].priority)) {
+                selected = static_cast<int>(irq);
+            }
+        }
+
+        if (selected < 0) {
+            return;
+        }
+
+        lines[selected].pending = false;
+        active_irqs.push_back(selected);
+        g_vtable[vtable_offset + selected]();
+        active_irqs.pop_back();
+    }
+}
+
+}  // namespace
+
+
+/*******************************************************************************
+ * CORE & NVIC FUNCTIONS
+ ******************************************************************************/
+
+void __enable_irq()
+{
+    primask = 0;
+    takePendingIrqs();
+}
+
+void __disable_irq()
+{
+    primask = 1;
+}
+
+uint32_t __get_PRIMASK()
+{
+    return primask;
+}
+
+void __WFI()
+{
+}
+
+void NVIC_SetPriority(IRQn_Type irq_nb, uint32_t priority)
+{
+    lines[irq_nb].priority = priority;
+    takePendingIrqs();
+}
+
+uint32_t NVIC_GetPriority(IRQn_Type irq_nb)
+{
+    return lines[irq_nb].priority;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq_nb)
+{
+    lines[irq_nb].enabled = true;
+    takePendingIrqs();
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq_nb)
+{
+    lines[irq_nb].enabled = false;
+}
+
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irq_nb)
+{
+    return lines[irq_nb].enabled;
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type irq_nb)
+{
+    lines[irq_nb].pending = true;
+    takePendingIrqs();
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq_nb)
+{
+    lines[irq_nb].pending = false;
+}
+
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irq_nb)
+{
+    return lines[irq_nb].pending;
+}
+
+
+/*******************************************************************************
+ * SIMULATION CONTROL
+ ******************************************************************************/
+
+int host_mcu::getActiveIrq()
+{
+    return active_irqs.empty() ? -1 : active_irqs.back();
+}
+
+size_t host_mcu::getNbActiveIrqs()
+{
+    return active_irqs.size();
+}
+
+void host_mcu::reset()
+{
+    primask = 0;
+    lines   = {};
+    active_irqs.clear();
+}
+
+
+/*******************************************************************************
+ * VECTOR TABLE
+ ******************************************************************************/
+
+extern "C" {
+volatile InterruptHandler hal::device::g_vtable[nb_irqs];
+
+void hal::device::handleError(void)
+{
+    fprintf(stderr, "Unexpected interrupt, active line %d\n",
+            host_mcu::getActiveIrq());
+    abort();
+}
+}
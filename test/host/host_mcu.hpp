@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * Simulated MCU the host tests are built against. Do not include directly, use
+ * mcu.hpp with MCU_HOST defined instead.
+ *
+ * Only the core is modelled: PRIMASK and an NVIC with a few IRQ lines. Pending
+ * a line whose priority is higher than the current execution priority runs its
+ * g_vtable handler right away on the caller's stack, just as the core would
+ * preempt the caller. The simulation is not thread-safe: interrupts are only
+ * ever taken by the thread that pends or unmasks them.
+ ******************************************************************************/
+
+#ifndef _HAL_TEST_HOST_MCU_HPP
+#define _HAL_TEST_HOST_MCU_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include <cstddef>
+#include <cstdint>
+
+
+/*******************************************************************************
+ * PUBLIC TYPE DEFINITIONS
+ ******************************************************************************/
+
+enum IRQn_Type {
+    HostIrq0_IRQn = 0,
+    HostIrq1_IRQn = 1,
+    HostIrq2_IRQn = 2,
+    HostIrq3_IRQn = 3,
+    HostIrq4_IRQn = 4,
+    HostIrq5_IRQn = 5,
+    HostIrq6_IRQn = 6,
+    HostIrq7_IRQn = 7
+};
+
+
+/*******************************************************************************
+ * CONSTANT DEFINITIONS
+ ******************************************************************************/
+
+/** Offset to apply to each @ref IRQn_Type to get the actual handler index
+ * in the vtable */
+constexpr unsigned vtable_offset = 16;
+constexpr unsigned nb_host_irq_lines = 8;
+/** Number of IRQS */
+constexpr unsigned nb_irqs = vtable_offset + nb_host_irq_lines;
+
+/** Tick rate of the timers unless another one is requested */
+constexpr uint32_t default_timer_tick_hz = 1000000;
+
+/** Number of IRQ lines reserved to be used as software interrupts */
+constexpr std::size_t nb_interrupt_executors = 4;
+
+
+/*******************************************************************************
+ * CORE & NVIC FUNCTIONS
+ ******************************************************************************/
+
+void __enable_irq();
+void __disable_irq();
+uint32_t __get_PRIMASK();
+/** Returns at once: there is nothing to wait for on the host */
+void __WFI();
+
+void NVIC_SetPriority(IRQn_Type irq_nb, uint32_t priority);
+uint32_t NVIC_GetPriority(IRQn_Type irq_nb);
+void NVIC_EnableIRQ(IRQn_Type irq_nb);
+void NVIC_DisableIRQ(IRQn_Type irq_nb);
+uint32_t NVIC_GetEnableIRQ(IRQn_Type irq_nb);
+void NVIC_SetPendingIRQ(IRQn_Type irq_nb);
+void NVIC_ClearPendingIRQ(IRQn_Type irq_nb);
+uint32_t NVIC_GetPendingIRQ(IRQn_Type irq_nb);
+
+
+namespace host_mcu
+{
+/*******************************************************************************
+ * SIMULATION CONTROL
+ ******************************************************************************/
+
+/** Line whose handler is currently running, -1 in thread mode */
+int getActiveIrq();
+/** Number of handlers currently preempted, plus the one running */
+std::size_t getNbActiveIrqs();
+/** Mask every line and forget pending, enabled and active states */
+void reset();
+
+}  // namespace host_mcu
+
+#endif
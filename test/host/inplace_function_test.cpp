@@ -0,0 +1,219 @@
+/*******************************************************************************
+ * Host test of InplaceFunction, along with a micro-benchmark comparing the
+ * cost of storing, moving and calling callbacks with std::function. Global
+ * operator new is replaced to count the allocations each of them makes.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "check.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <executor.hpp>
+#include <functional>
+#include <inplace_function.hpp>
+#include <new>
+#include <vector>
+
+using namespace std;
+using namespace hal;
+
+
+/*******************************************************************************
+ * ALLOCATION COUNTING
+ ******************************************************************************/
+
+namespace
+{
+size_t nb_allocations = 0;
+}
+
+void* operator new(size_t size)
+{
+    ++nb_allocations;
+    if (void* ptr = malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS
+ ******************************************************************************/
+
+namespace
+{
+constexpr unsigned nb_iterations = 10000000;
+
+/* Captures as much state as a driver callback bound to its arguments */
+struct Capture {
+    unsigned* counter;
+    void* args[5];
+
+    void operator()()
+    {
+        ++*counter;
+    }
+};
+
+/* Counts its live copies to check that every stored object is destroyed */
+struct Tracked {
+    static inline int nb_alive = 0;
+    int* nb_calls;
+
+    Tracked(int* nb_calls): nb_calls{nb_calls}
+    {
+        ++nb_alive;
+    }
+    Tracked(const Tracked& other): nb_calls{other.nb_calls}
+    {
+        ++nb_alive;
+    }
+    ~Tracked()
+    {
+        --nb_alive;
+    }
+
+    void operator()()
+    {
+        ++*nb_calls;
+    }
+};
+
+void testSemantics()
+{
+    int nb_calls = 0;
+
+    {
+        InplaceFunction<void()> f;
+        CHECK(!f);
+
+        bool thrown = false;
+        try {
+            f();
+        } catch (bad_function_call&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+
+        f = Tracked{&nb_calls};
+        CHECK(static_cast<bool>(f));
+        CHECK(Tracked::nb_alive == 1);
+        f();
+        CHECK(nb_calls == 1);
+
+        InplaceFunction<void(), 64> g{move(f)};
+        CHECK(!f);
+        CHECK(Tracked::nb_alive == 1);
+        g();
+        CHECK(nb_calls == 2);
+
+        g = nullptr;
+        CHECK(!g);
+        CHECK(Tracked::nb_alive == 0);
+
+        g = Tracked{&nb_calls};
+    }
+    CHECK(Tracked::nb_alive == 0);
+
+    InplaceFunction<int(int, int)> add{[](int a, int b) { return a + b; }};
+    CHECK(add(2, 3) == 5);
+}
+
+/* Time taken to build, move into a queue slot, call and destroy a callback,
+ * as pushing then running an event does */
+template<typename Function>
+double benchStoreAndCall(size_t& nb_allocs)
+{
+    unsigned counter = 0;
+    Function slot;
+
+    size_t allocs_before = nb_allocations;
+    double elapsed_ns    = host_test::measureNs([&] {
+        for (unsigned i = 0; i < nb_iterations; ++i) {
+            Function f{Capture{&counter, {}}};
+            slot = move(f);
+            slot();
+            slot = nullptr;
+        }
+    });
+    nb_allocs = nb_allocations - allocs_before;
+
+    CHECK(counter == nb_iterations);
+
+    return elapsed_ns / nb_iterations;
+}
+
+/* Time taken to call already stored callbacks */
+template<typename Function>
+double benchCall()
+{
+    constexpr unsigned nb_functions = 64;
+    unsigned counter                = 0;
+    vector<Function> functions;
+
+    for (unsigned i = 0; i < nb_functions; ++i) {
+        functions.emplace_back(Capture{&counter, {}});
+    }
+
+    double elapsed_ns = host_test::measureNs([&] {
+        for (unsigned i = 0; i < nb_iterations; ++i) {
+            functions[i % nb_functions]();
+        }
+    });
+
+    CHECK(counter == nb_iterations);
+
+    return elapsed_ns / nb_iterations;
+}
+
+void benchmark()
+{
+    size_t inplace_allocs;
+    size_t std_allocs;
+
+    double inplace_store = benchStoreAndCall<Event>(inplace_allocs);
+    double std_store     = benchStoreAndCall<function<void()>>(std_allocs);
+    double inplace_call  = benchCall<Event>();
+    double std_call      = benchCall<function<void()>>();
+
+    CHECK(inplace_allocs == 0);
+
+    printf("Callback of %zu bytes, Event of %zu bytes, std::function of %zu "
+           "bytes\n",
+           sizeof(Capture), sizeof(Event), sizeof(function<void()>));
+    printf("Store, call & destroy: InplaceFunction %.2f ns (%zu allocations), "
+           "std::function %.2f ns (%zu allocations)\n",
+           inplace_store, inplace_allocs, std_store, std_allocs);
+    printf("Call: InplaceFunction %.2f ns, std::function %.2f ns\n",
+           inplace_call, std_call);
+}
+
+}  // namespace
+
+
+/*******************************************************************************
+ * MAIN
+ ******************************************************************************/
+
+int main()
+{
+    testSemantics();
+    benchmark();
+
+    return host_test::report("inplace_function_test");
+}
@@ -0,0 +1,187 @@
+/*******************************************************************************
+ * Host test of the preemption order of InterruptExecutors. Each executor is
+ * backed by a line of the simulated NVIC, which runs handlers as the core
+ * would: a pended line preempts the running code if its priority is higher,
+ * and otherwise waits for every handler of higher or equal priority to
+ * return.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "check.hpp"
+
+#include <device/irqs.hpp>
+#include <hardware/mcu.hpp>
+#include <interrupt_executor.hpp>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace hal;
+using namespace hal::device;
+
+
+/*******************************************************************************
+ * PRIVATE VARIABLES
+ ******************************************************************************/
+
+namespace
+{
+/* NVIC priorities, lower values preempt higher ones */
+constexpr uint32_t high_priority = 1;
+constexpr uint32_t mid_priority  = 2;
+constexpr uint32_t low_priority  = 3;
+
+InterruptExecutor* high_executor;
+InterruptExecutor* mid_executor;
+InterruptExecutor* low_executor;
+
+/* What ran, in order */
+vector<string> trace;
+
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS
+ ******************************************************************************/
+
+void installHandlers()
+{
+    g_vtable[vtable_offset + HostIrq1_IRQn] = [] {
+        high_executor->onSoftwareInterrupt();
+    };
+    g_vtable[vtable_offset + HostIrq2_IRQn] = [] {
+        mid_executor->onSoftwareInterrupt();
+    };
+    g_vtable[vtable_offset + HostIrq3_IRQn] = [] {
+        low_executor->onSoftwareInterrupt();
+    };
+}
+
+Event traced(const char* name)
+{
+    return [name] { trace.push_back(name); };
+}
+
+/* A higher priority event pushed by a handler runs before the pushEvent
+ * call returns, a lower priority one once every handler above it returned */
+void testNestedPreemption()
+{
+    trace.clear();
+
+    low_executor->pushEvent([] {
+        trace.push_back("low begin");
+        CHECK(host_mcu::getActiveIrq() == HostIrq3_IRQn);
+
+        high_executor->pushEvent([] {
+            trace.push_back("high begin");
+            CHECK(host_mcu::getNbActiveIrqs() == 2);
+
+            /* Neither preempts the high priority handler, the mid one then
+             * preempts the low one which is still running */
+            mid_executor->pushEvent(traced("mid"));
+            low_executor->pushEvent(traced("low again"));
+            trace.push_back("high end");
+        });
+
+        trace.push_back("low end");
+    });
+
+    CHECK(trace
+          == (vector<string>{"low begin", "high begin", "high end", "mid",
+                             "low end", "low again"}));
+    CHECK(host_mcu::getActiveIrq() == -1);
+}
+
+/* Pushing from thread mode, i.e. from the EventLoop, preempts it at once */
+void testThreadModePreemption()
+{
+    trace.clear();
+
+    mid_executor->pushEvent(traced("mid"));
+    trace.push_back("thread");
+
+    CHECK(trace == (vector<string>{"mid", "thread"}));
+}
+
+/* Events pushed while interrupts are masked run by NVIC priority as soon as
+ * they are enabled again, whatever the order they were pushed in */
+void testMaskedInterrupts()
+{
+    trace.clear();
+
+    disableInterrupts();
+    low_executor->pushEvent(traced("low"));
+    mid_executor->pushEvent(traced("mid"));
+    high_executor->pushEvent(traced("high"));
+    CHECK(trace.empty());
+    enableInterrupts();
+
+    CHECK(trace == (vector<string>{"high", "mid", "low"}));
+}
+
+/* Events of a same executor never preempt one another */
+void testSamePriority()
+{
+    trace.clear();
+
+    mid_executor->pushEvent([] {
+        trace.push_back("first begin");
+        mid_executor->pushEvent(traced("second"));
+        mid_executor->pushEvent(traced("third"));
+        trace.push_back("first end");
+    });
+
+    CHECK(trace
+          == (vector<string>{"first begin", "first end", "second", "third"}));
+}
+
+/* Raising the priority of an executor lets its events preempt the ones that
+ * used to preempt them */
+void testPriorityChange()
+{
+    trace.clear();
+
+    low_executor->setNvicPriority(0);
+    CHECK(low_executor->getNvicPriority() == 0);
+
+    high_executor->pushEvent([] {
+        trace.push_back("high begin");
+        low_executor->pushEvent(traced("low"));
+        trace.push_back("high end");
+    });
+
+    low_executor->setNvicPriority(low_priority);
+
+    CHECK(trace == (vector<string>{"high begin", "low", "high end"}));
+}
+
+}  // namespace
+
+
+/*******************************************************************************
+ * MAIN
+ ******************************************************************************/
+
+int main()
+{
+    host_mcu::reset();
+
+    InterruptExecutor high{HostIrq1_IRQn, high_priority};
+    InterruptExecutor mid{HostIrq2_IRQn, mid_priority};
+    InterruptExecutor low{HostIrq3_IRQn, low_priority};
+
+    high_executor = &high;
+    mid_executor  = &mid;
+    low_executor  = &low;
+    installHandlers();
+
+    testNestedPreemption();
+    testThreadModePreemption();
+    testMaskedInterrupts();
+    testSamePriority();
+    testPriorityChange();
+
+    return host_test::report("interrupt_executor_test");
+}
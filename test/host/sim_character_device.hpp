@@ -0,0 +1,129 @@
+/*******************************************************************************
+ * A character device for host tests. Writes and reads only complete when the
+ * test tells so, from what would be the device interrupt.
+ ******************************************************************************/
+
+#ifndef _HAL_TEST_SIM_CHARACTER_DEVICE_HPP
+#define _HAL_TEST_SIM_CHARACTER_DEVICE_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include <cstddef>
+#include <device/character_device.hpp>
+#include <optional>
+#include <string>
+
+
+namespace host_test
+{
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+class SimCharacterDevice : public hal::device::CharacterDevice<char>
+{
+  public:
+    /* ------------------------------------------------------------------ *
+     * Simulation control
+     * ------------------------------------------------------------------ */
+
+    bool isWriting() const
+    {
+        return write_buf != nullptr;
+    }
+
+    bool isReading() const
+    {
+        return read_buf != nullptr;
+    }
+
+    /** Complete the running write, its data is appended to @ref output */
+    void completeWrite()
+    {
+        const char* buf = write_buf;
+        size_t size     = write_size;
+
+        output.append(buf, size);
+        write_buf = nullptr;
+        write_complete_callback(
+            size, hal::device::ErrorStatus{hal::device::ErrorCode::Success});
+    }
+
+    /** Receive the given characters, the running read completes once its
+     * buffer is full or its stop character is received. Characters received
+     * while no read is running are lost. @return The number of characters
+     * consumed */
+    size_t receive(const std::string& input)
+    {
+        size_t nb_consumed = 0;
+
+        while (read_buf != nullptr && nb_consumed < input.size()) {
+            char c               = input[nb_consumed++];
+            read_buf[nb_read++] = c;
+
+            if (nb_read == read_size || (stop_char && c == *stop_char)) {
+                size_t size = nb_read;
+
+                read_buf = nullptr;
+                read_complete_callback(
+                    size,
+                    hal::device::ErrorStatus{hal::device::ErrorCode::Success});
+            }
+        }
+
+        return nb_consumed;
+    }
+
+    /** Everything written so far */
+    std::string output;
+
+    /* ------------------------------------------------------------------ *
+     * CharacterDevice interface
+     * ------------------------------------------------------------------ */
+
+    void startWrite(const char* buf, size_t buf_size) override
+    {
+        write_buf  = buf;
+        write_size = buf_size;
+    }
+
+    bool cancelWrite(size_t& nb_written) override
+    {
+        nb_written = 0;
+        write_buf  = nullptr;
+
+        return true;
+    }
+
+    void startRead(char* buf,
+                   size_t buf_size,
+                   std::optional<char> stop_char = std::nullopt) override
+    {
+        read_buf        = buf;
+        read_size       = buf_size;
+        nb_read         = 0;
+        this->stop_char = stop_char;
+    }
+
+    bool cancelRead(size_t& nb_read) override
+    {
+        nb_read  = this->nb_read;
+        read_buf = nullptr;
+
+        return true;
+    }
+
+  private:
+    const char* write_buf = nullptr;
+    size_t write_size     = 0;
+    char* read_buf        = nullptr;
+    size_t read_size      = 0;
+    size_t nb_read        = 0;
+    std::optional<char> stop_char;
+};
+
+}  // namespace host_test
+
+#endif
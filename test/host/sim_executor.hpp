@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * An executor for host tests, whose events only run when the test tells so.
+ * It stands for the EventLoop, whose run() never returns.
+ ******************************************************************************/
+
+#ifndef _HAL_TEST_SIM_EXECUTOR_HPP
+#define _HAL_TEST_SIM_EXECUTOR_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include <cstddef>
+#include <event_queue.hpp>
+#include <executor.hpp>
+
+
+namespace host_test
+{
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+class SimExecutor : public hal::Executor
+{
+  public:
+    static constexpr std::size_t queue_size = 256;
+
+    /** Events are queued whatever their priority, they never allocate */
+    void pushEvent(hal::Event&& event_handler, Priority prio = 0) override
+    {
+        if (!event_queue.push(std::move(event_handler))) {
+            throw hal::EventQueueOverflowException{};
+        }
+        ++nb_pushed;
+    }
+
+    /** Run queued events, including the ones they push, until there is none
+     * left. @return The number of events run */
+    std::size_t runAll()
+    {
+        hal::Event event_handler;
+        std::size_t nb_run = 0;
+
+        while (event_queue.pop(event_handler)) {
+            event_handler();
+            ++nb_run;
+        }
+        event_handler = nullptr;
+
+        return nb_run;
+    }
+
+    bool empty() const
+    {
+        return event_queue.empty();
+    }
+
+    std::size_t getNbPushed() const
+    {
+        return nb_pushed;
+    }
+
+  private:
+    hal::EventQueue<hal::Event, queue_size> event_queue;
+    std::size_t nb_pushed = 0;
+};
+
+}  // namespace host_test
+
+#endif
@@ -0,0 +1,251 @@
+/*******************************************************************************
+ * A timer device for host tests, counting the ticks of a simulated clock that
+ * only moves forward when the test advances it. It supports both one-shot
+ * waits and free-running deadlines.
+ * Its interrupt is taken right away when a wait goes off, unless it is masked
+ * through suspendWait(), in which case it is taken by resumeWait(). The counter
+ * keeps on running meanwhile, as the TimerDevice interface requires.
+ ******************************************************************************/
+
+#ifndef _HAL_TEST_SIM_TIMER_DEVICE_HPP
+#define _HAL_TEST_SIM_TIMER_DEVICE_HPP
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <device/timer_device.hpp>
+#include <limits>
+
+
+namespace host_test
+{
+/*******************************************************************************
+ * CLASS DEFINITION
+ ******************************************************************************/
+
+class SimTimerDevice : public hal::device::TimerDevice
+{
+  public:
+    static constexpr std::size_t nb_channels = 4;
+
+    /** @param max_count
+     *  Largest count accepted by startWait(), i.e. the counter range
+     * @param tick_rate
+     *  Duration of the ticks, 1 µs by default */
+    SimTimerDevice(TickCount max_count = UINT32_MAX,
+                   TickRate tick_rate  = TickRate{1000000, 1})
+    : max_count{max_count}, tick_rate{tick_rate}
+    {
+    }
+
+    /* ------------------------------------------------------------------ *
+     * Simulation control
+     * ------------------------------------------------------------------ */
+
+    /** Let the given number of ticks elapse, taking the interrupts of every
+     * wait that goes off in the meantime, in order */
+    void advance(uint64_t nb_ticks)
+    {
+        uint64_t end = time + nb_ticks;
+        uint64_t next;
+
+        while ((next = nextExpiry()) <= end) {
+            time = next;
+            expire();
+        }
+        time = end;
+    }
+
+    /** Advance the clock to the next wait that goes off, if any.
+     * @return false if no wait is armed */
+    bool advanceToNextExpiry()
+    {
+        uint64_t next = nextExpiry();
+        if (next == never) {
+            return false;
+        }
+        advance(next - time);
+
+        return true;
+    }
+
+    /** Ticks elapsed since the device was built */
+    uint64_t getTime() const
+    {
+        return time;
+    }
+
+    /** Ticks elapsing each time the device interrupt is masked, i.e. the
+     * time spent by the driver in its critical sections */
+    uint64_t critical_section_ticks = 0;
+    /** While set, suspendWait() fails */
+    bool fail_suspend = false;
+    /** Number of interrupts taken */
+    uint32_t nb_interrupts = 0;
+    /** Number of times the device was programmed */
+    uint32_t nb_programmings = 0;
+
+    /* ------------------------------------------------------------------ *
+     * TimerDevice interface
+     * ------------------------------------------------------------------ */
+
+    TickCount getRemainingWaitTime() override
+    {
+        return wait_armed ? static_cast<TickCount>(wait_deadline - time) : 0;
+    }
+
+    bool suspendWait() override
+    {
+        if (fail_suspend) {
+            return false;
+        }
+        masked = true;
+
+        return true;
+    }
+
+    bool resumeWait() override
+    {
+        if (masked) {
+            advance(critical_section_ticks);
+        }
+        masked = false;
+        takePendingInterrupts();
+
+        return true;
+    }
+
+    bool cancelWait() override
+    {
+        wait_armed = false;
+        /* A wait that went off already cannot be cancelled */
+        return true;
+    }
+
+    bool startWait(TickCount count) override
+    {
+        if (count > max_count) {
+            return false;
+        }
+        ++nb_programmings;
+        wait_armed    = true;
+        wait_deadline = time + count;
+        if (count == 0) {
+            expire();
+        }
+
+        return true;
+    }
+
+    void usleep(uint32_t us) override
+    {
+        advance(us);
+    }
+
+    TickCount getMaxWaitCount() const override
+    {
+        return max_count;
+    }
+
+    TickRate getTickRate() const override
+    {
+        return tick_rate;
+    }
+
+    void startFreeRunning() override
+    {
+    }
+
+    uint64_t getCounter() override
+    {
+        return time;
+    }
+
+    size_t getNbDeadlineChannels() const override
+    {
+        return nb_channels;
+    }
+
+    void setDeadline(size_t channel, uint64_t deadline) override
+    {
+        ++nb_programmings;
+        channels[channel] = deadline;
+        /* A deadline that went past already goes off right away */
+        if (deadline <= time) {
+            expire();
+        }
+    }
+
+    void clearDeadline(size_t channel) override
+    {
+        channels[channel] = never;
+    }
+
+  private:
+    static constexpr uint64_t never = std::numeric_limits<uint64_t>::max();
+
+    const TickCount max_count;
+    const TickRate tick_rate;
+    uint64_t time = 0;
+    bool masked   = false;
+    /* Interrupts that went off while masked */
+    unsigned nb_pending = 0;
+    bool in_handler     = false;
+
+    bool wait_armed        = false;
+    uint64_t wait_deadline = 0;
+    std::array<uint64_t, nb_channels> channels{never, never, never, never};
+
+    uint64_t nextExpiry() const
+    {
+        uint64_t next = wait_armed ? wait_deadline : never;
+
+        return std::min(next, *std::min_element(channels.begin(),
+                                                channels.end()));
+    }
+
+    /* Stop the waits that are due, as the hardware would, and raise their
+     * interrupts */
+    void expire()
+    {
+        if (wait_armed && wait_deadline <= time) {
+            wait_armed = false;
+            ++nb_pending;
+        }
+        for (auto& channel : channels) {
+            if (channel <= time) {
+                channel = never;
+                ++nb_pending;
+            }
+        }
+
+        takePendingInterrupts();
+    }
+
+    /* The handler cannot preempt itself, waits it arms that are already due
+     * are handled by the loop once it returns */
+    void takePendingInterrupts()
+    {
+        if (in_handler) {
+            return;
+        }
+
+        in_handler = true;
+        while (!masked && nb_pending > 0) {
+            --nb_pending;
+            ++nb_interrupts;
+            wait_complete_callback(
+                hal::device::ErrorStatus{hal::device::ErrorCode::Success});
+        }
+        in_handler = false;
+    }
+};
+
+}  // namespace host_test
+
+#endif
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ * Host test of the SteadyClock on a simulated timer device. Readings are in ns
+ * whatever the tick rate of the device, they must be exact at whole seconds
+ * and never go backwards, including past the range of a 32-bit counter.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "check.hpp"
+#include "sim_executor.hpp"
+#include "sim_timer_device.hpp"
+
+#include <chrono>
+#include <driver/timer_driver.hpp>
+#include <ratio>
+#include <steady_clock.hpp>
+#include <type_traits>
+
+using namespace std;
+using namespace std::chrono_literals;
+using namespace hal;
+using namespace hal::device;
+using namespace hal::driver;
+using namespace host_test;
+
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS
+ ******************************************************************************/
+
+namespace
+{
+static_assert(chrono::is_clock_v<SteadyClock>);
+static_assert(is_same_v<SteadyClock::period, nano>);
+
+int64_t nowNs()
+{
+    return SteadyClock::now().time_since_epoch().count();
+}
+
+void testNotStarted()
+{
+    bool thrown = false;
+    try {
+        SteadyClock::now();
+    } catch (SteadyClockNotStartedException&) {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+/* 1 µs, 9.26 ns and 30.5 µs ticks */
+void testTickRate(TimerDevice::TickRate tick_rate)
+{
+    SimTimerDevice device{UINT32_MAX, tick_rate};
+    uint64_t ticks_per_s = tick_rate.clk_hz / tick_rate.divider;
+
+    SteadyClock::setSource(device);
+    CHECK(nowNs() == 0);
+
+    device.advance(1);
+    CHECK(nowNs() == static_cast<int64_t>(1000000000ULL * tick_rate.divider
+                                          / tick_rate.clk_hz));
+
+    device.advance(ticks_per_s - 1);
+    CHECK(SteadyClock::now().time_since_epoch() == 1s);
+
+    /* Past 2^32 ticks */
+    int64_t last = nowNs();
+    bool monotonic = true;
+    for (int i = 0; i < 5000; ++i) {
+        device.advance(1000003);
+        int64_t time = nowNs();
+        monotonic &= (time > last);
+        last = time;
+    }
+    CHECK(monotonic);
+    CHECK(device.getTime() > UINT32_MAX);
+    CHECK(nowNs() == static_cast<int64_t>(tick_rate.toNanoseconds(
+                         device.getTime())));
+}
+
+/* The clock shares its counter with a FreeRunning TimerDriver */
+void testSharedDevice()
+{
+    SimExecutor executor;
+    SimTimerDevice device;
+    SteadyClock::setSource(device);
+    TimerDriver driver{executor, device, 0, TimerDriver::QueueType::SortedList,
+                       TimerDriver::Mode::FreeRunning};
+    SteadyClock::time_point fired_at;
+
+    device.advance(500);
+    SteadyClock::time_point armed_at = SteadyClock::now();
+    driver.asyncWait(10ms, [&fired_at](ErrorStatus&) {
+        fired_at = SteadyClock::now();
+    });
+    while (device.advanceToNextExpiry()) { executor.runAll(); }
+
+    CHECK(fired_at - armed_at == 10ms);
+}
+
+}  // namespace
+
+
+/*******************************************************************************
+ * MAIN
+ ******************************************************************************/
+
+int main()
+{
+    testNotStarted();
+    testTickRate(TimerDevice::TickRate{1000000, 1});
+    testTickRate(TimerDevice::TickRate{108000000, 1});
+    testTickRate(TimerDevice::TickRate{32768, 1});
+    testSharedDevice();
+
+    return host_test::report("steady_clock_test");
+}
@@ -0,0 +1,224 @@
+/*******************************************************************************
+ * Host test of the heap allocations of the TimerDriver: the global operator
+ * new is replaced by one that counts its calls. Arming and cancelling
+ * intrusive timers must never allocate, whatever the queue and mode of the
+ * driver. Handle-based timers may only allocate while their pool grows.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "check.hpp"
+#include "sim_executor.hpp"
+#include "sim_timer_device.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <driver/timer_driver.hpp>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace hal::device;
+using namespace hal::driver;
+using namespace host_test;
+
+
+/*******************************************************************************
+ * ALLOCATION COUNTING
+ ******************************************************************************/
+
+namespace
+{
+size_t nb_allocations = 0;
+}  // namespace
+
+/* The array and nothrow forms call this one. Over-aligned allocations are not
+ * counted, the driver makes none. */
+void* operator new(size_t size)
+{
+    ++nb_allocations;
+    if (void* ptr = malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+
+/*******************************************************************************
+ * PRIVATE TYPE DEFINITIONS
+ ******************************************************************************/
+
+namespace
+{
+constexpr size_t nb_timers = 64;
+constexpr size_t nb_ops    = 200000;
+
+/* Timers are busy from the time they are armed until their callback ran */
+struct Tally {
+    array<bool, nb_timers> busy{};
+    size_t nb_fired   = 0;
+    size_t nb_aborted = 0;
+
+    void onWait(size_t i, ErrorStatus& status)
+    {
+        busy[i] = false;
+        if (status.get_code() == ErrorCode::Aborted) {
+            ++nb_aborted;
+        } else {
+            ++nb_fired;
+        }
+    }
+};
+
+/* Arms itself again from its own callback */
+struct Ticker {
+    TimerDriver::IntrusiveTimer timer;
+    size_t nb_ticks = 0;
+
+    Ticker(TimerDriver& driver): timer{driver}
+    {
+    }
+
+    void arm()
+    {
+        timer.asyncWait(chrono::microseconds{37}, [this](ErrorStatus& status) {
+            if (!status) {
+                ++nb_ticks;
+                arm();
+            }
+        });
+    }
+};
+
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS
+ ******************************************************************************/
+
+void testIntrusiveTimers(TimerDriver::QueueType queue_type,
+                         TimerDriver::Mode mode)
+{
+    mt19937 rng{4};
+    SimExecutor executor;
+    SimTimerDevice device;
+    TimerDriver driver{executor, device, 0, queue_type, mode};
+    vector<unique_ptr<TimerDriver::IntrusiveTimer>> timers;
+    Tally tally;
+    Ticker ticker{driver};
+
+    for (size_t i = 0; i < nb_timers; ++i) {
+        timers.push_back(make_unique<TimerDriver::IntrusiveTimer>(driver));
+    }
+
+    size_t nb_before = nb_allocations;
+
+    ticker.arm();
+    for (size_t n = 0; n < nb_ops; ++n) {
+        size_t i = uniform_int_distribution<size_t>{0, nb_timers - 1}(rng);
+
+        if (!tally.busy[i]) {
+            auto timeout = uniform_int_distribution<uint64_t>{1, 1000}(rng);
+            auto slack   = uniform_int_distribution<uint64_t>{0, 100}(rng);
+            tally.busy[i] = true;
+            timers[i]->asyncWait(
+                chrono::microseconds{timeout}, chrono::microseconds{slack},
+                [&tally, i](ErrorStatus& status) { tally.onWait(i, status); });
+        } else {
+            timers[i]->cancelWait();
+        }
+
+        device.advance(uniform_int_distribution<uint64_t>{0, 10}(rng));
+        executor.runAll();
+    }
+    ticker.timer.cancelWait();
+    while (device.advanceToNextExpiry()) { executor.runAll(); }
+    executor.runAll();
+
+    CHECK(nb_allocations == nb_before);
+    CHECK(tally.nb_fired > 0);
+    CHECK(tally.nb_aborted > 0);
+    CHECK(ticker.nb_ticks > 0);
+    CHECK(driver.getNbPendingWaits() == 0);
+}
+
+/* Once the pool holds as many operations as are ever pending at once, they
+ * are recycled */
+void testHandleTimers()
+{
+    SimExecutor executor;
+    SimTimerDevice device;
+    TimerDriver driver{executor, device};
+    vector<TimerDriver::Timer> timers;
+    size_t nb_fired = 0;
+
+    timers.reserve(nb_timers);
+
+    auto runRound = [&] {
+        timers.clear();
+        for (size_t i = 0; i < nb_timers; ++i) {
+            timers.push_back(driver.asyncWait(
+                chrono::microseconds{100 + i},
+                [&nb_fired](ErrorStatus& status) { nb_fired += !status; }));
+        }
+        /* Every other one is cancelled, the others go off */
+        for (size_t i = 0; i < nb_timers; i += 2) {
+            timers[i].cancelWait();
+        }
+        while (device.advanceToNextExpiry()) { executor.runAll(); }
+        executor.runAll();
+    };
+
+    size_t nb_before = nb_allocations;
+    runRound();
+    size_t nb_growth = nb_allocations - nb_before;
+
+    nb_before = nb_allocations;
+    for (size_t round = 0; round < 1000; ++round) {
+        runRound();
+    }
+
+    CHECK(nb_growth > 0);
+    CHECK(nb_allocations == nb_before);
+    CHECK(nb_fired == 1001 * nb_timers / 2);
+
+    printf("Handle timers: %zu allocations to grow the pool to %zu "
+           "operations, none afterwards\n",
+           nb_growth, nb_timers);
+}
+
+}  // namespace
+
+
+/*******************************************************************************
+ * MAIN
+ ******************************************************************************/
+
+int main()
+{
+    for (auto queue_type : {TimerDriver::QueueType::SortedList,
+                            TimerDriver::QueueType::PairingHeap}) {
+        for (auto mode :
+             {TimerDriver::Mode::OneShot, TimerDriver::Mode::FreeRunning}) {
+            testIntrusiveTimers(queue_type, mode);
+        }
+    }
+    testHandleTimers();
+
+    return host_test::report("timer_alloc_test");
+}
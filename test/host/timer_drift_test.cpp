@@ -0,0 +1,177 @@
+/*******************************************************************************
+ * Host test of the drift of periodic waits over 1M periods on a simulated
+ * clock. Each period, the callback takes some time to run and arms two more
+ * waits, one of which it cancels right away, so the device is reprogrammed
+ * several times per period while ticks elapse in every critical section of
+ * the driver. Deadlines must nonetheless stay exact multiples of the period:
+ * the lateness of the callbacks must not grow with the number of periods.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "check.hpp"
+#include "sim_executor.hpp"
+#include "sim_timer_device.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <driver/timer_driver.hpp>
+
+using namespace std;
+using namespace hal::device;
+using namespace hal::driver;
+using namespace host_test;
+
+
+/*******************************************************************************
+ * PRIVATE TYPE DEFINITIONS
+ ******************************************************************************/
+
+namespace
+{
+/* In device ticks, i.e. µs */
+constexpr uint64_t period         = 100;
+constexpr uint64_t handler_ticks  = 7;
+constexpr uint64_t critical_ticks = 3;
+constexpr uint64_t timeout        = 50;
+constexpr uint32_t nb_periods     = 1000000;
+
+struct Tally {
+    SimTimerDevice& device;
+    TimerDriver& driver;
+    uint64_t start;
+    uint32_t nb_periods    = 0;
+    uint32_t nb_overruns   = 0;
+    uint32_t nb_timeouts   = 0;
+    uint64_t max_lateness  = 0;
+    uint64_t last_lateness = 0;
+    uint32_t nb_early      = 0;
+
+    void onPeriod(ErrorStatus& status, unsigned overruns)
+    {
+        if (status.get_code() == ErrorCode::Aborted) {
+            return;
+        }
+
+        nb_overruns += overruns;
+        ++nb_periods;
+
+        uint64_t deadline = start + nb_periods * period;
+        uint64_t time     = device.getTime();
+        if (time < deadline) {
+            ++nb_early;
+            return;
+        }
+        last_lateness = time - deadline;
+        max_lateness  = max(max_lateness, last_lateness);
+
+        /* Work done by the callback, then a timeout that goes off before the
+         * next period and one that is cancelled */
+        device.advance(handler_ticks);
+        driver.asyncWait(chrono::microseconds{timeout},
+                         [this](ErrorStatus&) { ++nb_timeouts; });
+        driver.asyncWait(chrono::microseconds{timeout / 2}, [](ErrorStatus&) {
+        }).cancelWait();
+    }
+};
+
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS
+ ******************************************************************************/
+
+void testPeriodicDrift(TimerDriver::Mode mode, const char* mode_name)
+{
+    SimExecutor executor;
+    SimTimerDevice device;
+    TimerDriver driver{executor, device, 0,
+                       TimerDriver::QueueType::SortedList, mode};
+    Tally tally{device, driver, device.getTime()};
+
+    device.critical_section_ticks = critical_ticks;
+
+    auto timer = driver.asyncWaitPeriodic(
+        chrono::microseconds{period},
+        [&tally](ErrorStatus& status, unsigned nb_overruns) {
+            tally.onPeriod(status, nb_overruns);
+        });
+
+    while (tally.nb_periods < nb_periods) {
+        device.advanceToNextExpiry();
+        executor.runAll();
+    }
+    timer.cancelWait();
+    executor.runAll();
+
+    CHECK(tally.nb_early == 0);
+    CHECK(tally.nb_overruns == 0);
+    CHECK(tally.nb_timeouts >= nb_periods - 1);
+    /* Lateness only comes from the critical sections the callback waited
+     * for, it does not add up */
+    CHECK(tally.max_lateness <= 2 * critical_ticks);
+    CHECK(device.nb_programmings >= nb_periods);
+
+    printf("%s: %u periods, %u device reprogrammings, lateness max %llu "
+           "last %llu ticks\n",
+           mode_name, tally.nb_periods, device.nb_programmings,
+           static_cast<unsigned long long>(tally.max_lateness),
+           static_cast<unsigned long long>(tally.last_lateness));
+}
+
+/* For comparison, waits chained from their callback drift by the latency of
+ * each callback */
+void printChainedDrift()
+{
+    SimExecutor executor;
+    SimTimerDevice device;
+    TimerDriver driver{executor, device};
+    uint32_t nb_waits = 0;
+    uint64_t start    = device.getTime();
+
+    device.critical_section_ticks = critical_ticks;
+
+    struct Chain {
+        TimerDriver& driver;
+        SimTimerDevice& device;
+        uint32_t& nb_waits;
+
+        void arm()
+        {
+            driver.asyncWait(chrono::microseconds{period},
+                             [this](ErrorStatus&) {
+                                 ++nb_waits;
+                                 device.advance(handler_ticks);
+                                 arm();
+                             });
+        }
+    } chain{driver, device, nb_waits};
+
+    chain.arm();
+    while (nb_waits < nb_periods / 10) {
+        device.advanceToNextExpiry();
+        executor.runAll();
+    }
+
+    printf("Chained asyncWait: %u periods, drift %llu ticks\n", nb_waits,
+           static_cast<unsigned long long>(device.getTime() - start
+                                           - nb_waits * period));
+}
+
+}  // namespace
+
+
+/*******************************************************************************
+ * MAIN
+ ******************************************************************************/
+
+int main()
+{
+    testPeriodicDrift(TimerDriver::Mode::FreeRunning, "FreeRunning");
+    testPeriodicDrift(TimerDriver::Mode::OneShot, "OneShot");
+    printChainedDrift();
+
+    return host_test::report("timer_drift_test");
+}
@@ -0,0 +1,151 @@
+/*******************************************************************************
+ * Host test of the waits longer than the device range. A device that cannot
+ * count past 37 ticks runs the same random workload as an unbounded one: every
+ * wait must go off at the same time on both, the bounded device only taking
+ * more interrupts at the end of each epoch. Waits of hours must work as well
+ * on a 16-bit counter.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "check.hpp"
+#include "sim_executor.hpp"
+#include "sim_timer_device.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <driver/timer_driver.hpp>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono_literals;
+using namespace hal::device;
+using namespace hal::driver;
+using namespace host_test;
+
+
+/*******************************************************************************
+ * PRIVATE TYPE DEFINITIONS
+ ******************************************************************************/
+
+namespace
+{
+constexpr size_t nb_waits = 10000;
+
+/* Time at which each wait went off, in device ticks, i.e. µs */
+struct Tally {
+    SimTimerDevice& device;
+    vector<uint64_t> fired_at;
+    size_t nb_aborted = 0;
+
+    void onWait(size_t i, ErrorStatus& status)
+    {
+        if (status.get_code() == ErrorCode::Aborted) {
+            ++nb_aborted;
+            return;
+        }
+        fired_at[i] = device.getTime();
+    }
+};
+
+struct Run {
+    vector<uint64_t> fired_at;
+    TimerDriver::Statistics statistics;
+};
+
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS
+ ******************************************************************************/
+
+/* Waits of up to 10 ms are armed in turn, some are cancelled right away */
+Run runWorkload(TimerDevice::TickCount max_count)
+{
+    mt19937 rng{3};
+    SimExecutor executor;
+    SimTimerDevice device{max_count};
+    TimerDriver driver{executor, device};
+    Tally tally{device, vector<uint64_t>(nb_waits, 0)};
+    vector<TimerDriver::Timer> timers;
+
+    for (size_t i = 0; i < nb_waits; ++i) {
+        auto timeout = uniform_int_distribution<uint64_t>{0, 10000}(rng);
+        timers.push_back(driver.asyncWait(
+            chrono::microseconds{timeout},
+            [&tally, i](ErrorStatus& status) { tally.onWait(i, status); }));
+
+        if (i % 7 == 0 && timeout > 0) {
+            timers[i].cancelWait();
+        }
+        device.advance(uniform_int_distribution<uint64_t>{0, 50}(rng));
+        executor.runAll();
+    }
+    while (device.advanceToNextExpiry()) { executor.runAll(); }
+
+    CHECK(driver.getNbPendingWaits() == 0);
+
+    return Run{tally.fired_at, driver.getStatistics()};
+}
+
+void testSameTiming()
+{
+    Run bounded   = runWorkload(37);
+    Run unbounded = runWorkload(UINT32_MAX);
+
+    CHECK(bounded.fired_at == unbounded.fired_at);
+    CHECK(bounded.statistics.nb_expirations
+          == unbounded.statistics.nb_expirations);
+    CHECK(unbounded.statistics.nb_epoch_interrupts == 0);
+    CHECK(bounded.statistics.nb_epoch_interrupts > 0);
+    CHECK(bounded.statistics.nb_interrupts
+          - bounded.statistics.nb_epoch_interrupts
+          == unbounded.statistics.nb_interrupts);
+
+    printf("37-tick device: %u interrupts, %u of them epoch ends, "
+           "unbounded device: %u interrupts\n",
+           bounded.statistics.nb_interrupts,
+           bounded.statistics.nb_epoch_interrupts,
+           unbounded.statistics.nb_interrupts);
+}
+
+/* A single wait is split into as many epochs as needed and goes off on time */
+void testLongWait(TimerDevice::TickCount max_count,
+                  chrono::microseconds timeout)
+{
+    SimExecutor executor;
+    SimTimerDevice device{max_count};
+    TimerDriver driver{executor, device};
+    uint64_t ticks = timeout.count();
+    Tally tally{device, vector<uint64_t>(1, 0)};
+
+    driver.asyncWait(timeout, [&tally](ErrorStatus& status) {
+        tally.onWait(0, status);
+    });
+    while (device.advanceToNextExpiry()) { executor.runAll(); }
+
+    uint64_t nb_epochs = (ticks + max_count - 1) / max_count;
+    CHECK(tally.fired_at[0] == ticks);
+    CHECK(driver.getStatistics().nb_epoch_interrupts == nb_epochs - 1);
+    CHECK(device.nb_interrupts == nb_epochs);
+}
+
+}  // namespace
+
+
+/*******************************************************************************
+ * MAIN
+ ******************************************************************************/
+
+int main()
+{
+    testSameTiming();
+    testLongWait(37, 10000us);
+    testLongWait(0xFFFF, chrono::duration_cast<chrono::microseconds>(2h));
+    /* Beyond the 32-bit µs range */
+    testLongWait(UINT32_MAX, chrono::duration_cast<chrono::microseconds>(3h));
+
+    return host_test::report("timer_epoch_test");
+}
@@ -0,0 +1,287 @@
+/*******************************************************************************
+ * Host benchmark of the TimerDriver queues: 10k to 100k timers are inserted,
+ * half of them are cancelled in random order and the others go off. Both
+ * backends are compared with a model of the delta-encoded std::list the driver
+ * used before, whose insertion and cancellation are linear. Driver figures
+ * include the whole asyncWait/cancelWait path while the model only counts its
+ * list operations.
+ * Every timer must go off exactly once, in deadline order and never early, or
+ * be cancelled.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * INCLUDE DIRECTIVES
+ ******************************************************************************/
+
+#include "check.hpp"
+#include "sim_executor.hpp"
+#include "sim_timer_device.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <driver/timer_driver.hpp>
+#include <functional>
+#include <list>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace hal::device;
+using namespace hal::driver;
+using namespace host_test;
+
+
+/*******************************************************************************
+ * PRIVATE TYPE DEFINITIONS
+ ******************************************************************************/
+
+namespace
+{
+enum class Pattern {
+    /* Same timeout for every timer, as protocol timeouts armed in turn */
+    Increasing,
+    /* Timeouts spread at random over 10 s */
+    Random
+};
+
+/* Records how the timers of the driver went off */
+struct Tally {
+    SimTimerDevice& device;
+    vector<uint64_t> deadlines;
+    size_t nb_fired        = 0;
+    size_t nb_aborted      = 0;
+    size_t nb_early        = 0;
+    uint64_t last_fired_at = 0;
+    bool in_order          = true;
+
+    void onWait(size_t i, ErrorStatus& status)
+    {
+        if (status.get_code() == ErrorCode::Aborted) {
+            ++nb_aborted;
+            return;
+        }
+        ++nb_fired;
+        nb_early += (device.getTime() < deadlines[i]);
+        in_order &= (deadlines[i] >= last_fired_at);
+        last_fired_at = deadlines[i];
+    }
+};
+
+struct Result {
+    double insert_ns;
+    double cancel_ns;
+    double expire_ns;
+};
+
+/* The wait queue of the TimerDriver before it had selectable backends: each
+ * wait stores its delay from the previous one */
+class DeltaList
+{
+  public:
+    void insert(uint32_t id, uint64_t wait_time, function<void()>&& callback)
+    {
+        auto it = ops.begin();
+        while (it != ops.end() && wait_time >= it->delta) {
+            wait_time -= it->delta;
+            ++it;
+        }
+        if (it != ops.end()) {
+            it->delta -= wait_time;
+        }
+        ops.insert(it, Op{id, wait_time, move(callback)});
+    }
+
+    void cancel(uint32_t id)
+    {
+        auto it = find_if(ops.begin(), ops.end(),
+                          [id](const Op& op) { return op.id == id; });
+        auto next = std::next(it);
+        if (next != ops.end()) {
+            next->delta += it->delta;
+        }
+        ops.erase(it);
+    }
+
+    void expireAll()
+    {
+        while (!ops.empty()) {
+            ops.front().callback();
+            ops.pop_front();
+        }
+    }
+
+  private:
+    struct Op {
+        uint32_t id;
+        uint64_t delta;
+        function<void()> callback;
+    };
+
+    list<Op> ops;
+};
+
+
+/*******************************************************************************
+ * PRIVATE FUNCTION IMPLEMENTATIONS
+ ******************************************************************************/
+
+/* Timeouts in device ticks, i.e. µs */
+vector<uint64_t> makeTimeouts(size_t nb_timers, Pattern pattern)
+{
+    mt19937 rng{1};
+    vector<uint64_t> timeouts(nb_timers);
+
+    for (auto& timeout : timeouts) {
+        timeout = (pattern == Pattern::Increasing)
+                      ? 1000000
+                      : uniform_int_distribution<uint64_t>{1, 10000000}(rng);
+    }
+
+    return timeouts;
+}
+
+/* Every other timer is cancelled, in random order */
+vector<size_t> makeCancelOrder(size_t nb_timers)
+{
+    mt19937 rng{2};
+    vector<size_t> order;
+
+    for (size_t i = 0; i < nb_timers; i += 2) {
+        order.push_back(i);
+    }
+    shuffle(order.begin(), order.end(), rng);
+
+    return order;
+}
+
+Result runDriver(TimerDriver::QueueType queue_type,
+                 size_t nb_timers,
+                 Pattern pattern)
+{
+    SimExecutor executor;
+    SimTimerDevice device;
+    TimerDriver driver{executor, device, 0, queue_type};
+    vector<uint64_t> timeouts = makeTimeouts(nb_timers, pattern);
+    vector<size_t> cancel_order = makeCancelOrder(nb_timers);
+    vector<TimerDriver::Timer> timers;
+    Tally tally{device, vector<uint64_t>(nb_timers)};
+    Result result;
+
+    timers.reserve(nb_timers);
+
+    result.insert_ns = host_test::measureNs([&] {
+        for (size_t i = 0; i < nb_timers; ++i) {
+            tally.deadlines[i] = device.getTime() + timeouts[i];
+            timers.push_back(driver.asyncWait(
+                chrono::microseconds{timeouts[i]},
+                [&tally, i](ErrorStatus& status) { tally.onWait(i, status); }));
+            /* Timers are armed in turn, not all at once */
+            if (pattern == Pattern::Increasing) {
+                device.advance(1);
+            }
+        }
+    });
+
+    result.cancel_ns = host_test::measureNs([&] {
+        for (size_t i : cancel_order) {
+            timers[i].cancelWait();
+        }
+        executor.runAll();
+    });
+
+    result.expire_ns = host_test::measureNs([&] {
+        while (device.advanceToNextExpiry()) { executor.runAll(); }
+    });
+
+    CHECK(tally.nb_aborted == cancel_order.size());
+    CHECK(tally.nb_fired == nb_timers - cancel_order.size());
+    CHECK(tally.nb_early == 0);
+    CHECK(tally.in_order);
+    CHECK(driver.getNbPendingWaits() == 0);
+
+    result.insert_ns /= nb_timers;
+    result.cancel_ns /= cancel_order.size();
+    result.expire_ns /= nb_timers - cancel_order.size();
+
+    return result;
+}
+
+Result runDeltaList(size_t nb_timers, Pattern pattern)
+{
+    DeltaList list;
+    vector<uint64_t> timeouts = makeTimeouts(nb_timers, pattern);
+    vector<size_t> cancel_order = makeCancelOrder(nb_timers);
+    size_t nb_fired = 0;
+    Result result;
+
+    result.insert_ns = host_test::measureNs([&] {
+        for (size_t i = 0; i < nb_timers; ++i) {
+            /* No time elapses in the model: timers armed in turn are one
+             * tick later than the previous one */
+            uint64_t timeout =
+                timeouts[i] + ((pattern == Pattern::Increasing) ? i : 0);
+            list.insert(i, timeout, [&nb_fired] { ++nb_fired; });
+        }
+    });
+
+    result.cancel_ns = host_test::measureNs([&] {
+        for (size_t i : cancel_order) {
+            list.cancel(i);
+        }
+    });
+
+    result.expire_ns = host_test::measureNs([&] { list.expireAll(); });
+
+    CHECK(nb_fired == nb_timers - cancel_order.size());
+
+    result.insert_ns /= nb_timers;
+    result.cancel_ns /= cancel_order.size();
+    result.expire_ns /= nb_timers - cancel_order.size();
+
+    return result;
+}
+
+void print(const char* name, size_t nb_timers, Pattern pattern, Result result)
+{
+    printf("%-14s %6zu timers, %-10s: insert %8.1f ns, cancel %8.1f ns, "
+           "expire %8.1f ns\n",
+           name, nb_timers,
+           (pattern == Pattern::Increasing) ? "increasing" : "random",
+           result.insert_ns, result.cancel_ns, result.expire_ns);
+}
+
+void benchmark(size_t nb_timers, Pattern pattern)
+{
+    print("PairingHeap", nb_timers, pattern,
+          runDriver(TimerDriver::QueueType::PairingHeap, nb_timers, pattern));
+
+    /* Linear insertion with random timeouts is too slow to go further */
+    if (pattern == Pattern::Increasing || nb_timers <= 10000) {
+        print("SortedList", nb_timers, pattern,
+              runDriver(TimerDriver::QueueType::SortedList, nb_timers,
+                        pattern));
+    }
+    /* Likewise for any pattern with the former list */
+    if (nb_timers <= 10000) {
+        print("std::list", nb_timers, pattern,
+              runDeltaList(nb_timers, pattern));
+    }
+}
+
+}  // namespace
+
+
+/*******************************************************************************
+ * MAIN
+ ******************************************************************************/
+
+int main()
+{
+    for (size_t nb_timers : {10000, 100000}) {
+        benchmark(nb_timers, Pattern::Increasing);
+        benchmark(nb_timers, Pattern::Random);
+    }
+
+    return host_test::report("timer_queue_test");
+}